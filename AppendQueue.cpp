@@ -0,0 +1,67 @@
+#include "AppendQueue.hpp"
+
+namespace sftb {
+    AppendQueue::AppendQueue(std::size_t capacity, OverflowPolicy policy) : capacity(capacity), policy(policy) {}
+
+    AppendQueue::~AppendQueue() {
+        Node *node = head.load(std::memory_order_acquire);
+        while (node != nullptr) {
+            Node *next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    void AppendQueue::drop(std::size_t characters) {
+        droppedTexts.fetch_add(1, std::memory_order_relaxed);
+        droppedCharacters.fetch_add(characters, std::memory_order_relaxed);
+    }
+
+    bool AppendQueue::push(sf::String text) {
+        std::size_t size = text.getSize();
+        if (size == 0) return true;
+
+        // reserve room for the text first, so the queue never holds more than its capacity with DropNewest
+        std::size_t pending = pendingCharacters.load(std::memory_order_relaxed);
+        do {
+            if (policy == OverflowPolicy::DropNewest && capacity != 0 && pending + size > capacity) {
+                drop(size);
+                return false;
+            }
+        } while (!pendingCharacters.compare_exchange_weak(pending, pending + size, std::memory_order_relaxed));
+
+        // the consumer only ever takes the whole list (see drain()), so pushing is a plain compare and swap of head
+        Node *node = new Node{std::move(text)};
+        node->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed));
+        return true;
+    }
+
+    sf::String AppendQueue::drain() {
+        Node *node = head.exchange(nullptr, std::memory_order_acquire);
+        if (node == nullptr) return sf::String();
+
+        // reverse the list into the order the texts were pushed
+        Node *oldest = nullptr;
+        std::size_t total = 0;
+        while (node != nullptr) {
+            Node *next = node->next;
+            node->next = oldest;
+            oldest = node;
+            total += node->text.getSize();
+            node = next;
+        }
+        pendingCharacters.fetch_sub(total, std::memory_order_relaxed);
+
+        sf::String text;
+        for (node = oldest; node != nullptr;) {
+            if (policy == OverflowPolicy::DropOldest && capacity != 0 && total > capacity) drop(node->text.getSize());
+            else text += node->text;
+            total -= node->text.getSize();
+            Node *next = node->next;
+            delete node;
+            node = next;
+        }
+        return text;
+    }
+}
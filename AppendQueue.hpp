@@ -0,0 +1,88 @@
+#ifndef SFML_TEXTBOX_APPENDQUEUE_HPP
+#define SFML_TEXTBOX_APPENDQUEUE_HPP
+
+#include <SFML/System/String.hpp>
+#include <atomic>
+#include <cstddef>
+
+namespace sftb {
+    // what AppendQueue::push() does once the queue holds its capacity
+    enum class OverflowPolicy {
+        // the pushed text is dropped, and push() returns false
+        DropNewest,
+        // the text is queued, and the oldest texts are dropped when the queue is drained so the rest fit
+        DropOldest
+    };
+
+    /**
+     * Text appended to a TextBox by other threads, such as log producers. Any number of threads may push() text
+     * without locking, while the thread owning the TextBox drains it: TextBox::update() appends everything pushed
+     * since the previous update() in a single Document::append().
+     * The queue holds up to getCapacity() characters (0 for no limit), texts beyond it are dropped according to the
+     * OverflowPolicy and counted by getDroppedTexts() and getDroppedCharacters().
+     */
+    class AppendQueue {
+    private:
+        struct Node {
+            sf::String text;
+            Node *next = nullptr;
+        };
+
+        // most recently pushed first, see drain()
+        std::atomic<Node *> head{nullptr};
+        std::atomic<std::size_t> pendingCharacters{0};
+        std::atomic<std::size_t> droppedTexts{0};
+        std::atomic<std::size_t> droppedCharacters{0};
+        const std::size_t capacity;
+        const OverflowPolicy policy;
+
+        void drop(std::size_t characters);
+    public:
+        explicit AppendQueue(std::size_t capacity = 0, OverflowPolicy policy = OverflowPolicy::DropNewest);
+        ~AppendQueue();
+
+        AppendQueue(const AppendQueue &) = delete;
+        AppendQueue &operator=(const AppendQueue &) = delete;
+
+        // may be called from any thread, returns false if the text was dropped
+        bool push(sf::String text);
+
+        // pushes text followed by a line break
+        bool pushLine(sf::String line) {
+            line += '\n';
+            return push(std::move(line));
+        }
+
+        // removes every text pushed so far and returns them in the order they were pushed, concatenated
+        // must only be called by one thread at a time (the consumer)
+        sf::String drain();
+
+        [[nodiscard]] std::size_t getCapacity() const {
+            return capacity;
+        }
+
+        [[nodiscard]] OverflowPolicy getOverflowPolicy() const {
+            return policy;
+        }
+
+        // characters pushed and not yet drained, including those DropOldest will drop
+        [[nodiscard]] std::size_t getPendingCharacters() const {
+            return pendingCharacters.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::size_t getDroppedTexts() const {
+            return droppedTexts.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::size_t getDroppedCharacters() const {
+            return droppedCharacters.load(std::memory_order_relaxed);
+        }
+
+        void resetDropCounters() {
+            droppedTexts.store(0, std::memory_order_relaxed);
+            droppedCharacters.store(0, std::memory_order_relaxed);
+        }
+    };
+}
+
+#endif //SFML_TEXTBOX_APPENDQUEUE_HPP
@@ -0,0 +1,32 @@
+#ifndef SFML_TEXTBOX_BLOCKSELECTION_HPP
+#define SFML_TEXTBOX_BLOCKSELECTION_HPP
+
+#include <cstddef>
+#include <algorithm>
+
+namespace sftb {
+    /**
+     * A rectangular (column) selection. On each line from firstLine to lastLine, the characters between the
+     * horizontal offsets left and right (relative to the start of the line) are selected.
+     */
+    struct BlockSelection {
+        std::size_t firstLine, lastLine;
+        float left, right;
+
+        // the rectangle spanned by two corners, in any order
+        static BlockSelection between(std::size_t firstLine, float firstX, std::size_t secondLine, float secondX) {
+            return {std::min(firstLine, secondLine), std::max(firstLine, secondLine),
+                    std::min(firstX, secondX), std::max(firstX, secondX)};
+        }
+
+        [[nodiscard]] std::size_t getNumberLines() const {
+            return lastLine - firstLine + 1;
+        }
+
+        [[nodiscard]] bool containsLine(std::size_t line) const {
+            return firstLine <= line && line <= lastLine;
+        }
+    };
+}
+
+#endif //SFML_TEXTBOX_BLOCKSELECTION_HPP
@@ -3,7 +3,7 @@
 #include <algorithm>
 
 namespace sftb {
-    Caret::Caret(TextBox &box, Pos position) :
+    Caret::Caret(TextBox &box, Key, Pos position) :
             reference(box.getReference()), pos((**reference).getCharPos(position)), selectionEndPos(nullptr),
             style((**reference).getCaretStyle()) {
     }
@@ -38,8 +38,10 @@ namespace sftb {
 
     void Caret::removeSelectedText() {
         if (hasSelection()) {
+            Pos start = std::min(getPosition(), getSelectionEndPos());
             (**reference).removeText(getPosition(), getSelectionEndPos());
-            removeSelection();
+            // removed characters transfer their anchors to the preceding character, place the caret explicitly
+            setPosition(start);
         }
     }
 
@@ -47,6 +49,10 @@ namespace sftb {
         return hasSelection() ? (**reference).getTextFrom(getPosition(), getSelectionEndPos()) : "";
     }
 
+    std::string Caret::getSelectedTextUtf8() const {
+        return hasSelection() ? (**reference).getTextUtf8(getPosition(), getSelectionEndPos()) : "";
+    }
+
     void Caret::insert(const sf::String &string) {
         removeSelectedText();
         Pos position = (**reference).insertText(getPosition(), string);
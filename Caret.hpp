@@ -4,6 +4,7 @@
 #include <SFML/Graphics/Drawable.hpp>
 #include <SFML/System/String.hpp>
 #include <memory>
+#include <string>
 #include <cassert>
 #include "Pos.hpp"
 #include "CaretStyle.hpp"
@@ -13,7 +14,7 @@
 namespace sftb {
     class TextBox;
 
-    // todo - multiple caret support
+    // a TextBox has a primary caret and any number of additional carets, see TextBox::addCaret()
     class Caret : public sf::Drawable {
         friend class TextBox;
     private:
@@ -22,7 +23,10 @@ namespace sftb {
         std::shared_ptr<CaretStyle> style;
         HighlightHandle selectedTextHighlight;
 
-        explicit Caret(TextBox &box, Pos position = {});
+        // only a TextBox creates carets, the key lets it do so through std::make_unique
+        struct Key {
+            explicit Key() = default;
+        };
 
         Caret(Caret &&) = default;
         Caret &operator=(Caret &&) = default;
@@ -34,6 +38,8 @@ namespace sftb {
         }
 
     public:
+        Caret(TextBox &box, Key, Pos position = {});
+
         Caret(const Caret &) = delete;
         Caret &operator=(const Caret &) = delete;
 
@@ -80,6 +86,7 @@ namespace sftb {
         void removeSelectedText();
 
         [[nodiscard]] sf::String getSelectedText() const;
+        [[nodiscard]] std::string getSelectedTextUtf8() const;
         void insert(const sf::String &string);
     };
 }
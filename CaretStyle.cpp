@@ -18,6 +18,7 @@ namespace sftb {
         shape.setPosition(getCaretPosition(c));
         shape.setFillColor(getCurrentCaretColor());
         target.draw(shape, states);
+        detail::countDrawCall();
 
         if (c.getTextBox().isPositionOnScreen(c.getPosition()))
             c.getTextBox().setRedrawRequired();
@@ -1,5 +1,5 @@
 #include "CharPos.hpp"
-#include "TextBox.hpp"
+#include "Document.hpp"
 
 namespace sftb::detail {
     void CharPosData::reduceRelative() const {
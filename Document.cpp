@@ -0,0 +1,1218 @@
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "Document.hpp"
+#include "DocumentSnapshot.hpp"
+#include "Trace.hpp"
+
+namespace sftb {
+    bool Document::LineLengthCompare::operator()(Line **left, Line **right) const {
+        return (**right).getNumberCharacters() < (**left).getNumberCharacters();
+    }
+
+    void Document::reportChange(std::size_t line, std::size_t removedLines, std::size_t insertedLines) {
+        if (!snapshotChunks.last.expired()) trackSnapshotChange(line, removedLines, insertedLines);
+        if (lineOffsets.valid) updateLineOffsets(line, removedLines, insertedLines);
+        if (!pendingChange) {
+            pendingChange = DocumentChange{line, removedLines, insertedLines};
+            return;
+        }
+
+        // the union of both changes, in the current coordinates; lines after the pending change are shifted by it
+        DocumentChange &change = *pendingChange;
+        std::size_t start = std::min(change.line, line);
+        std::size_t end = std::max(change.line + change.insertedLines, line + removedLines);
+        std::size_t previousEnd = end - change.insertedLines + change.removedLines;
+        change = {start, previousEnd - start, end - removedLines + insertedLines - start};
+    }
+
+    void Document::updateLineOffsets(std::size_t line, std::size_t removedLines, std::size_t insertedLines) {
+        LineOffsets &offsets = lineOffsets;
+        std::size_t blocks = offsets.lines.size();
+        // the block containing line, lines inserted at the end of the document belong to the last block
+        std::size_t first = std::min(offsets.lines.search(line), blocks - 1);
+        std::size_t offset = line - offsets.lines.prefixSum(first);
+        std::size_t block = first;
+        for (std::size_t remaining = removedLines; remaining > 0; block++) {
+            assert(block < blocks && "removed lines out of bounds");
+            std::size_t removed = std::min(remaining, offsets.lines.get(block) - offset);
+            // unsigned arithmetic, wraps around to subtract
+            offsets.lines.add(block, std::size_t() - removed);
+            remaining -= removed;
+            offset = 0;
+        }
+        offsets.lines.add(first, insertedLines);
+
+        // the lengths of the blocks containing the change are summed again
+        std::size_t start = offsets.lines.prefixSum(first);
+        for (std::size_t changed = first; changed < std::max(block, first + 1); changed++) {
+            std::size_t end = start + offsets.lines.get(changed);
+            offsets.characters.add(changed, getLinesLength(start, end) - offsets.characters.get(changed));
+            start = end;
+        }
+
+        std::size_t count = offsets.lines.get(first);
+        if (count > 2 * LINE_OFFSETS_BLOCK && first == blocks - 1) {
+            // lines appended at the end of the document are split into new blocks, the others are unchanged
+            start = offsets.lines.prefixSum(first);
+            offsets.lines.truncate(first);
+            offsets.characters.truncate(first);
+            for (std::size_t end = start + count; start < end; start += LINE_OFFSETS_BLOCK) {
+                std::size_t blockEnd = std::min(end, start + LINE_OFFSETS_BLOCK);
+                offsets.lines.pushBack(blockEnd - start);
+                offsets.characters.pushBack(getLinesLength(start, blockEnd));
+            }
+        } else if (count > 2 * LINE_OFFSETS_BLOCK || blocks > 4 * (getNumberLines() / LINE_OFFSETS_BLOCK + 1)) {
+            compactLineOffsets();
+        }
+    }
+
+    void Document::compactLineOffsets() {
+        LineOffsets &offsets = lineOffsets;
+        std::vector<std::size_t> counts, lengths;
+        std::size_t start = 0;
+        for (std::size_t block = 0; block < offsets.lines.size(); block++) {
+            std::size_t count = offsets.lines.get(block);
+            if (count > 2 * LINE_OFFSETS_BLOCK) {
+                for (std::size_t end = start + count, split = start; split < end; split += LINE_OFFSETS_BLOCK) {
+                    std::size_t splitEnd = std::min(end, split + LINE_OFFSETS_BLOCK);
+                    counts.push_back(splitEnd - split);
+                    lengths.push_back(getLinesLength(split, splitEnd));
+                }
+            } else if (!counts.empty() && counts.back() + count <= LINE_OFFSETS_BLOCK) {
+                counts.back() += count;
+                lengths.back() += offsets.characters.get(block);
+            } else {
+                counts.push_back(count);
+                lengths.push_back(offsets.characters.get(block));
+            }
+            start += count;
+        }
+
+        offsets.lines.build(counts.size(), [&counts](std::size_t block) {
+            return counts[block];
+        });
+        offsets.characters.build(lengths.size(), [&lengths](std::size_t block) {
+            return lengths[block];
+        });
+    }
+
+    void Document::ensureLineOffsets() const {
+        LineOffsets &offsets = lineOffsets;
+        if (offsets.valid) return;
+        std::size_t numberLines = getNumberLines();
+        // at least one block, which lines inserted into an empty document are added to
+        std::size_t blocks = std::max<std::size_t>(1, (numberLines + LINE_OFFSETS_BLOCK - 1) / LINE_OFFSETS_BLOCK);
+        offsets.lines.build(blocks, [numberLines](std::size_t block) {
+            return std::min(LINE_OFFSETS_BLOCK, numberLines - block * LINE_OFFSETS_BLOCK);
+        });
+        offsets.characters.build(blocks, [this, numberLines](std::size_t block) {
+            std::size_t start = block * LINE_OFFSETS_BLOCK;
+            return getLinesLength(start, std::min(numberLines, start + LINE_OFFSETS_BLOCK));
+        });
+        offsets.valid = true;
+    }
+
+    std::size_t Document::getLinesLength(std::size_t start, std::size_t end) const {
+        std::size_t length = 0;
+        for (std::size_t line = start; line < end; line++) {
+            length += getLineLength(line) + 1;
+        }
+        return length;
+    }
+
+    void Document::trackSnapshotChange(std::size_t line, std::size_t removedLines, std::size_t insertedLines) {
+        SnapshotChunks &tracked = snapshotChunks;
+        tracked.anyChanged = true;
+        std::size_t chunks = tracked.changed.size();
+        if (chunks == 0) tracked.rebuild = true;
+        if (tracked.rebuild) return;
+
+        // the chunk containing line, lines inserted at the end of the document belong to the last chunk
+        std::size_t first = std::min(tracked.lines.search(line), chunks - 1);
+        std::size_t offset = line - tracked.lines.prefixSum(first);
+        tracked.changed[first] = true;
+        std::size_t chunk = first;
+        for (std::size_t remaining = removedLines; remaining > 0; chunk++) {
+            assert(chunk < chunks && "removed lines out of bounds");
+            std::size_t removed = std::min(remaining, tracked.lines.get(chunk) - offset);
+            // unsigned arithmetic, wraps around to subtract
+            tracked.lines.add(chunk, std::size_t() - removed);
+            tracked.changed[chunk] = true;
+            remaining -= removed;
+            offset = 0;
+        }
+        tracked.lines.add(first, insertedLines);
+    }
+
+    void Document::notifyListeners() {
+        if (!pendingChange) return;
+        DocumentChange change = *pendingChange;
+        pendingChange.reset();
+        // by index, listeners may add listeners
+        for (std::size_t i = 0; i < listeners.size(); i++) {
+            listeners[i]->onDocumentChange(change);
+        }
+    }
+
+    unsigned Document::getLayoutId(const std::shared_ptr<const GlyphMetrics> &metrics, unsigned tabSize) {
+        // ids are never reused, lines laid out with an expired layout are laid out again when next used
+        layouts.erase(std::remove_if(layouts.begin(), layouts.end(), [](const Layout &layout) {
+            return layout.metrics.expired();
+        }), layouts.end());
+
+        for (const Layout &layout : layouts) {
+            if (layout.tabSize == tabSize && layout.metrics.lock() == metrics) return layout.id;
+        }
+        layouts.push_back({metrics, tabSize, nextLayoutId});
+        return nextLayoutId++;
+    }
+
+    std::size_t Document::getLineLength(std::size_t line) const {
+        return line == getNumberLines() ? 0 : getLine(line).getNumberCharacters();
+    }
+
+    std::size_t Document::getLongestLineLength() const {
+        const Line *longest = getLongestLine();
+        return longest == nullptr ? 0 : longest->getNumberCharacters();
+    }
+
+    const detail::Line *Document::getLongestLine() const {
+        assert(getNumberLines() == lineLength.size() && "lineLength and lines have different number of elements");
+        return lineLength.empty() ? nullptr : **lineLength.begin();
+    }
+
+    std::size_t Document::getLineIndex(const Line *line) const {
+        assert(line != nullptr && "line is nullptr");
+        // same logic as CharInfo getCharacterIndex
+        return line - (lines.data() + firstLine);
+    }
+
+    detail::Line &Document::getOrInsertLine(std::size_t line) {
+        assert(line <= getNumberLines() && "line out of bounds");
+        if (line != getNumberLines()) return getLine(line);
+        reportChange(line, 0, 1);
+        return lines.emplace_back(this);
+    }
+
+    CharPos Document::getCharPos(const Pos &pos) {
+        if (pos == getEndPos()) return endCharPosDataHolder.getCharPos(nullptr, nullptr);
+
+        Line &line = getLine(pos.line);
+        if (pos.position == line.getNumberCharacters())
+            return line.endLineCharPosDataHolder.getCharPos(&line, nullptr);
+
+        CharInfo &info = line.getCharInfo(pos.position);
+        return info.referenceHolder.getCharPos(&line, &info);
+    }
+
+    namespace detail {
+        void CharPosDataHolder::transfer(const CharPos &pos) {
+            if (active()) {
+                reference.lock()->setRelative(pos);
+                reference.reset();
+                SFTB_STATS_INCREMENT(charPosTransferred);
+            }
+        }
+
+        CharPos CharPosDataHolder::getCharPos(Line *line, CharInfo *info) {
+            if (active()) return reference.lock();
+            if (line != nullptr) line->mayHaveAnchors = true;
+            CharPos charPos = std::make_shared<CharPosData>(line == nullptr ? nullptr : line->getReference(), info);
+            reference = charPos;
+            SFTB_STATS_INCREMENT(charPosCreated);
+            return charPos;
+        }
+
+        void CharPosDataHolder::updateLine(Line &line) {
+            if (active()) reference.lock()->updateLine(line.getReference());
+        }
+
+        void CharPosDataHolder::updateCharInfo(CharInfo *info) {
+            if (active()) reference.lock()->updateCharInfo(info);
+        }
+    }
+
+    Pos Document::getRelativeCharacters(Pos pos, int characters) const {
+        // moves within a few lines are walked, longer ones are converted through offsets
+        std::size_t walked = 0;
+        if (characters < 0) {
+            characters = -characters;
+            do {
+                if (pos.position >= characters) {
+                    pos.position -= characters;
+                    return pos;
+                }
+
+                if (pos.line == 0) {
+                    pos.position = 0;
+                    return pos;
+                }
+
+                characters -= static_cast<int>(pos.position) + 1;
+                pos.position = getLineLength(--pos.line);
+            } while (characters > 0 && ++walked < RELATIVE_CHARACTERS_WALK);
+            if (characters <= 0) return pos;
+
+            std::size_t offset = posToOffset(pos);
+            return offsetToPos(offset - std::min(offset, static_cast<std::size_t>(characters)));
+        } else {
+            do {
+                std::size_t lengthLine = getLineLength(pos.line);
+                if (lengthLine - pos.position >= characters) {
+                    pos.position += characters;
+                    return pos;
+                }
+
+                if (pos.line == getNumberLines()) {
+                    pos.position = 0;
+                    return pos;
+                }
+
+                characters -= static_cast<int>(lengthLine - pos.position) + 1;
+                pos.position = 0;
+                pos.line++;
+            } while (characters > 0 && ++walked < RELATIVE_CHARACTERS_WALK);
+            if (characters <= 0) return pos;
+
+            return offsetToPos(posToOffset(pos) + static_cast<std::size_t>(characters));
+        }
+    }
+
+    std::size_t Document::posToOffset(Pos pos) const {
+        assert(pos.line <= getNumberLines() && "line out of bounds");
+        ensureLineOffsets();
+        // the lines before pos within its block are summed
+        std::size_t block = lineOffsets.lines.search(pos.line);
+        std::size_t start = lineOffsets.lines.prefixSum(block);
+        return lineOffsets.characters.prefixSum(block) + getLinesLength(start, pos.line) +
+               std::min(pos.position, getLineLength(pos.line));
+    }
+
+    Pos Document::offsetToPos(std::size_t offset) const {
+        ensureLineOffsets();
+        // every line has at least its line break, so the search finds the block containing offset
+        std::size_t block = lineOffsets.characters.search(offset);
+        if (block >= lineOffsets.characters.size()) return getEndPos();
+        std::size_t line = lineOffsets.lines.prefixSum(block);
+        offset -= lineOffsets.characters.prefixSum(block);
+        while (offset > getLineLength(line)) {
+            offset -= getLineLength(line) + 1;
+            line++;
+        }
+        return {line, offset};
+    }
+
+    Pos Document::getRelativeLine(Pos pos, int lineAmount) const {
+        if (lineAmount > 0) {
+            pos.line += lineAmount;
+            if (pos.line >= getNumberLines()) return getEndPos();
+        } else {
+            lineAmount = -lineAmount;
+            if (lineAmount == pos.line)
+                pos.line = 0;
+            else if (lineAmount > pos.line) return getStartPos();
+            else pos.line -= lineAmount;
+        }
+        pos.position = std::min(pos.position, getLineLength(pos.line));
+        return pos;
+    }
+
+    namespace {
+        void order(Pos &first, Pos &second) {
+            if (second < first)
+                std::swap(first, second);
+        }
+    }
+
+    sf::String Document::getTextFrom(Pos first, Pos second) const {
+        if (first == second) return "";
+        order(first, second);
+
+        // size the buffer once, rather than appending line by line
+        std::basic_string<Char> str(getTextSize(first, second), 0);
+        copyText(first, second, str.begin());
+        return str;
+    }
+
+    sf::String Document::getLineContents(std::size_t line, std::size_t start, std::size_t end) const {
+        LineView view = getLineView(line, start, end);
+        return std::basic_string<Char>(view.begin(), view.end());
+    }
+
+    LineView Document::getLineView(std::size_t lineNumber, std::size_t start, std::size_t end) const {
+        if (lineNumber == getNumberLines()) return {};
+
+        const Line &line = getLine(lineNumber);
+        // ensure start < end
+        if (end < start)
+            std::swap(start, end);
+        // ensure start and end within bounds
+        start = std::min(start, line.getNumberCharacters());
+        end = std::min(end, line.getNumberCharacters());
+
+        return {line.getText() + start, end - start};
+    }
+
+    std::size_t Document::getTextSize(Pos first, Pos second) const {
+        std::size_t size = 0;
+        forEachLineView(first, second, [&size](const LineView &view, bool lineBreak) {
+            size += view.size() + lineBreak;
+        });
+        return size;
+    }
+
+    std::size_t Document::getTextSizeUtf8(Pos first, Pos second) const {
+        std::size_t size = 0;
+        forEachLineView(first, second, [&size](const LineView &view, bool lineBreak) {
+            size += utf8::getEncodedLength(view.begin(), view.end()) + lineBreak;
+        });
+        return size;
+    }
+
+    std::string Document::getTextUtf8(Pos first, Pos second) const {
+        std::string str(getTextSizeUtf8(first, second), '\0');
+        copyTextUtf8(first, second, str.begin());
+        return str;
+    }
+
+#define ASSERT_POSITION(pos) \
+    assert((pos).line <= getNumberLines() && #pos " line out of bounds"); \
+    assert((pos).position <= getLineLength((pos).line) && #pos " position out of bounds");
+
+    Pos Document::insertText(Pos pos, const sf::String &text) {
+        SFTB_TRACE_SCOPE("insertText");
+        EditScope scope(*this);
+        ASSERT_POSITION(pos)
+
+        const Char *begin = text.getData();
+        const Char *end = begin + text.getSize();
+        auto newLines = static_cast<std::size_t>(std::count(begin, end, '\n'));
+
+        getOrInsertLine(pos.line);
+        if (newLines == 0) {
+            getLine(pos.line).insert(begin, end, pos.position);
+            reportChange(pos.line, 1, 1);
+            return {pos.line, pos.position + text.getSize()};
+        }
+
+        // insert all new lines at once, rather than shifting the following lines once per line
+        std::vector<Line> inserted;
+        inserted.reserve(newLines);
+        for (std::size_t i = 0; i < newLines; i++) inserted.emplace_back(this);
+        lines.insert(getLineIterator(pos.line + 1), std::make_move_iterator(inserted.begin()),
+                     std::make_move_iterator(inserted.end()));
+
+        // the remainder of the first line follows the inserted text
+        std::size_t lastLine = pos.line + newLines;
+        getLine(pos.line).move(getLine(lastLine), pos.position, 0);
+
+        std::size_t line = pos.line, position = pos.position;
+        const Char *lineEnd;
+        while ((lineEnd = std::find(begin, end, '\n')) != end) {
+            getLine(line++).insert(begin, lineEnd, position);
+            position = 0;
+            begin = lineEnd + 1;
+        }
+        getLine(lastLine).insert(begin, end, 0);
+        reportChange(pos.line, 1, newLines + 1);
+
+        return {lastLine, static_cast<std::size_t>(end - begin)};
+    }
+
+    std::vector<Pos> Document::insertText(const std::vector<Pos> &positions, const sf::String &text) {
+        SFTB_TRACE_SCOPE("insertText (multiple)");
+        assert(std::adjacent_find(positions.begin(), positions.end(), std::greater_equal<>()) == positions.end() &&
+               "positions are not sorted and unique");
+        if (positions.size() <= 1) {
+            return positions.empty() ? std::vector<Pos>() : std::vector<Pos>{insertText(positions.front(), text)};
+        }
+        EditScope scope(*this);
+        ASSERT_POSITION(positions.front())
+        ASSERT_POSITION(positions.back())
+        getOrInsertLine(positions.back().line);
+
+        const Char *begin = text.getData();
+        const Char *end = begin + text.getSize();
+        std::vector<const Char *> lineBreaks;
+        for (const Char *c = begin; c != end; c++) {
+            if (*c == '\n') lineBreaks.push_back(c);
+        }
+
+        std::vector<Pos> ends(positions.size());
+        if (lineBreaks.empty()) {
+            // all positions within a line are inserted at once
+            std::vector<std::size_t> linePositions;
+            for (std::size_t i = 0, j; i < positions.size(); i = j) {
+                linePositions.clear();
+                for (j = i; j < positions.size() && positions[j].line == positions[i].line; j++) {
+                    linePositions.push_back(positions[j].position);
+                    ends[j] = {positions[j].line, positions[j].position + (j - i + 1) * text.getSize()};
+                }
+                getLine(positions[i].line).insert(linePositions, begin, end);
+            }
+            std::size_t changed = positions.back().line - positions.front().line + 1;
+            reportChange(positions.front().line, changed, changed);
+            return ends;
+        }
+
+        // every position adds lineBreaks.size() lines. Rather than inserting them one position at a time (shifting all
+        // following lines each time), lines are moved to their final index in one pass, starting from the last line
+        std::size_t oldSize = getNumberLines();
+        std::size_t destination = oldSize + positions.size() * lineBreaks.size();
+        lines.reserve(firstLine + destination);
+        while (getNumberLines() < destination) lines.emplace_back(this);
+
+        // lines created for the current line, in reverse order
+        std::vector<Line> created;
+        // (index in created, index in ends) of the last line of each insertion
+        std::vector<std::pair<std::size_t, std::size_t>> lastLines;
+        std::size_t line = oldSize, i = positions.size();
+        while (destination != line) {
+            line--;
+            created.clear();
+            lastLines.clear();
+            for (; i > 0 && positions[i - 1].line == line; i--) {
+                std::size_t position = positions[i - 1].position;
+                // the text after the last line break, followed by the rest of the line
+                lastLines.emplace_back(created.size(), i - 1);
+                Line &last = created.emplace_back(this);
+                getLine(line).move(last, position, 0);
+                last.insert(lineBreaks.back() + 1, end, 0);
+                ends[i - 1].position = end - lineBreaks.back() - 1;
+
+                for (std::size_t b = lineBreaks.size() - 1; b > 0; b--) {
+                    created.emplace_back(this).insert(lineBreaks[b - 1] + 1, lineBreaks[b], 0);
+                }
+                getLine(line).insert(begin, lineBreaks.front(), position);
+            }
+
+            for (auto [index, endIndex] : lastLines) {
+                ends[endIndex].line = destination - 1 - index;
+            }
+            for (Line &createdLine : created) {
+                getLine(--destination) = std::move(createdLine);
+            }
+            destination--;
+            if (destination != line) getLine(destination) = std::move(getLine(line));
+        }
+
+        reportChange(positions.front().line, oldSize - positions.front().line,
+                     getNumberLines() - positions.front().line);
+        return ends;
+    }
+
+    Pos Document::insertLine(unsigned line, const sf::String &string) {
+        assert(line <= getNumberLines() && "line out of bounds");
+        EditScope scope(*this);
+        lines.emplace(getLineIterator(line), this);
+        reportChange(line, 0, 1);
+        return insertText({line, 0}, string);
+    }
+
+    void Document::removeText(Pos from, Pos to) {
+        if (from == to) return;
+        SFTB_TRACE_SCOPE("removeText");
+        EditScope scope(*this);
+        order(from, to);
+        ASSERT_POSITION(from)
+        ASSERT_POSITION(to)
+
+        if (from.line == to.line) {
+            getLine(from.line).remove(from.position, to.position);
+            reportChange(from.line, 1, 1);
+            return;
+        }
+
+        Line &fromLine = getLine(from.line);
+        if (from.position != fromLine.getNumberCharacters()) {
+            fromLine.remove(from.position);
+            reportChange(from.line, 1, 1);
+        }
+        unsigned line = from.line + 1;
+
+        removeLines(line, to.line);
+        to.line = line;
+
+        if (to.position != 0) {
+            getLine(to.line).remove(0, to.position);
+            reportChange(to.line, 1, 1);
+        }
+
+        if (to.line != getNumberLines()) {
+            Line &toLine = getLine(to.line);
+            if (toLine.getNumberCharacters() > 0) {
+                // move line contents from to -> from.line directly after from
+                toLine.move(fromLine, 0, from.position);
+                reportChange(from.line, 1, 1);
+            }
+            removeLine(to.line);
+        }
+    }
+
+    std::vector<Pos> Document::removeText(const std::vector<std::pair<Pos, Pos>> &ranges) {
+        SFTB_TRACE_SCOPE("removeText");
+        EditScope scope(*this);
+        std::vector<std::size_t> order(ranges.size());
+        for (std::size_t i = 0; i < ranges.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&ranges](std::size_t first, std::size_t second) {
+            return std::min(ranges[first].first, ranges[first].second) <
+                   std::min(ranges[second].first, ranges[second].second);
+        });
+
+        // overlapping and adjacent ranges are merged, so the merged ranges are separated by at least one character
+        std::vector<std::pair<Pos, Pos>> merged;
+        std::vector<std::size_t> mergedIndex(ranges.size());
+        for (std::size_t i : order) {
+            Pos from = std::min(ranges[i].first, ranges[i].second);
+            Pos to = std::max(ranges[i].first, ranges[i].second);
+            ASSERT_POSITION(from)
+            ASSERT_POSITION(to)
+            if (!merged.empty() && from <= merged.back().second) merged.back().second = std::max(merged.back().second, to);
+            else merged.emplace_back(from, to);
+            mergedIndex[i] = merged.size() - 1;
+        }
+
+        // the text after a range on its last line follows the start of the range once it is removed
+        std::vector<Pos> starts(merged.size());
+        std::size_t removedLines = 0;
+        for (std::size_t i = 0; i < merged.size(); i++) {
+            auto [from, to] = merged[i];
+            if (i > 0 && from.line == merged[i - 1].second.line) {
+                starts[i] = {starts[i - 1].line, starts[i - 1].position + from.position - merged[i - 1].second.position};
+            } else starts[i] = {from.line - removedLines, from.position};
+            removedLines += to.line - from.line;
+        }
+
+        // from the first range to the last. The rest of the last line of a range spanning several lines is appended to
+        // the line holding its first line, so each character moves at most once; the emptied lines are removed together
+        // at the end, so the following lines are moved once. Ranges within a line are removed together
+        std::size_t numberLines = getNumberLines();
+        // lines [start, end) emptied by a range, and the line holding the text before the range
+        struct EmptiedLines {
+            std::size_t start, end;
+            Line *holder;
+        };
+        std::vector<EmptiedLines> emptiedLines;
+        // line holding the rest of the last line of the latest range spanning several lines
+        std::size_t joinedLine = numberLines;
+        Line *joinedHolder = nullptr;
+        // ranges of holder not removed yet, in its current positions
+        Line *holder = nullptr;
+        std::vector<std::pair<std::size_t, std::size_t>> lineRanges;
+        std::size_t pendingRemoved = 0;
+        auto flush = [&holder, &lineRanges, &pendingRemoved] {
+            if (holder) holder->remove(lineRanges);
+            lineRanges.clear();
+            pendingRemoved = 0;
+        };
+
+        for (std::size_t i = 0; i < merged.size(); i++) {
+            auto [from, to] = merged[i];
+            if (from == to) continue;
+            Line *line = from.line == joinedLine ? joinedHolder : &getLine(from.line);
+            if (line != holder) {
+                flush();
+                holder = line;
+            }
+            // starts[i] is the position once the ranges before are removed, lineRanges are not removed yet
+            std::size_t start = starts[i].position + pendingRemoved;
+            if (from.line == to.line) {
+                lineRanges.emplace_back(start, start + to.position - from.position);
+                pendingRemoved += to.position - from.position;
+                continue;
+            }
+
+            if (start != holder->getNumberCharacters()) lineRanges.emplace_back(start, holder->getNumberCharacters());
+            flush();
+            if (to.line != numberLines) getLine(to.line).move(*line, to.position, line->getNumberCharacters());
+            emptiedLines.push_back({from.line + 1, std::min(to.line + 1, numberLines), line});
+            joinedLine = to.line;
+            joinedHolder = holder = line;
+        }
+        flush();
+
+        if (!emptiedLines.empty()) {
+            // as in removeLines(), the anchors of the emptied lines move to the end of the line holding the text before
+            // them, once no more text is removed from it
+            for (const EmptiedLines &emptied : emptiedLines) {
+                auto iterStart = getLineIterator(emptied.start);
+                auto iterEnd = getLineIterator(emptied.end);
+                bool anchors = std::any_of(iterStart, iterEnd, [](const Line &emptiedLine) {
+                    return emptiedLine.mayHaveAnchors;
+                });
+                CharPos transfer = anchors ? emptied.holder->endLineCharPosDataHolder.getCharPos(emptied.holder, nullptr) :
+                                   CharPos();
+                for (auto iter = iterStart; iter < iterEnd; iter++) {
+                    numberCharacters -= iter->getNumberCharacters();
+                    iter->prepareRemoveAll(transfer);
+                }
+            }
+
+            std::size_t destination = emptiedLines.front().start;
+            for (std::size_t i = 0; i < emptiedLines.size(); i++) {
+                std::size_t next = i + 1 < emptiedLines.size() ? emptiedLines[i + 1].start : numberLines;
+                for (std::size_t line = emptiedLines[i].end; line < next; line++) {
+                    getLine(destination++) = std::move(getLine(line));
+                }
+            }
+            lines.erase(getLineIterator(destination), lines.end());
+        }
+        // the lines between the first and last range are reported as a single change
+        bool removed = std::any_of(merged.begin(), merged.end(), [](const std::pair<Pos, Pos> &range) {
+            return range.first != range.second;
+        });
+        if (removed) {
+            std::size_t first = merged.front().first.line;
+            std::size_t changed = std::min(merged.back().second.line + 1, numberLines) - first;
+            reportChange(first, changed, changed - (numberLines - getNumberLines()));
+        }
+
+        std::vector<Pos> result(ranges.size());
+        for (std::size_t i = 0; i < ranges.size(); i++) result[i] = starts[mergedIndex[i]];
+        return result;
+    }
+
+    void Document::removeLine(unsigned int line) {
+        assert(line < getNumberLines() && "line out of bounds");
+        removeLines(line, line + 1);
+    }
+
+    void Document::removeLines(unsigned int start, unsigned int end) {
+        assert(start <= getNumberLines() &&
+               "start out of bounds"); // could omit check (implied by checks below) but may help debugging
+        assert(end <= getNumberLines() && "end out of bounds");
+        assert(start <= end && "start must be before end");
+        if (start == end) return;
+        SFTB_TRACE_SCOPE("removeLines");
+        EditScope scope(*this);
+        auto iterStart = getLineIterator(start);
+        auto iterEnd = getLineIterator(end);
+        // only lines which may have anchors are iterated over, in case transfer is required
+        bool anchors = std::any_of(iterStart, iterEnd, [](const Line &line) {
+            return line.mayHaveAnchors;
+        });
+        CharPos transfer = anchors ? getTransferPos(start, end) : CharPos();
+        for (auto iter = iterStart; iter < iterEnd; iter++) {
+            numberCharacters -= iter->getNumberCharacters();
+            iter->prepareRemoveAll(transfer);
+        }
+
+        if (start == 0) {
+            // rather than shifting the following lines, the removed lines (with their contents released) are left
+            // before firstLine. The gap is closed once it is as large as the remaining lines, so each removed line is
+            // moved at most once, on average
+            std::for_each(iterStart, iterEnd, [](Line &line) {
+                Line removed(std::move(line));
+            });
+            firstLine += end;
+            if (firstLine >= getNumberLines()) {
+                lines.erase(lines.begin(), getLineIterator(0));
+                firstLine = 0;
+            }
+        } else lines.erase(iterStart, iterEnd);
+        reportChange(start, end - start, 0);
+    }
+
+    Pos Document::append(const sf::String &text) {
+        SFTB_TRACE_SCOPE("append");
+        // the text and the removed lines are reported separately, so listeners can handle each at the end and start of
+        // the document
+        Pos end = getNumberLines() == 0 ? getStartPos() : Pos{getNumberLines() - 1, getLineLength(getNumberLines() - 1)};
+        end = insertText(end, text);
+
+        std::size_t numberLines = getNumberLines();
+        applyLimits();
+        end.line -= numberLines - getNumberLines();
+        return end;
+    }
+
+    void Document::applyLimits() {
+        std::size_t count = 0, characters = numberCharacters;
+        while (getNumberLines() - count > 1 && ((maxLines != 0 && getNumberLines() - count > maxLines) ||
+                                                (maxCharacters != 0 && characters > maxCharacters))) {
+            characters -= getLineLength(count++);
+        }
+        if (count != 0) removeLines(0, count);
+    }
+
+    Pos Document::getEndOf(const Pos &start, const sf::String &pattern) {
+        auto begin = std::make_reverse_iterator(pattern.getData() + pattern.getSize());
+        auto end = std::make_reverse_iterator(pattern.getData());
+        auto lineBreaks = static_cast<std::size_t>(std::count(begin, end, '\n'));
+        if (lineBreaks == 0) return {start.line, start.position + pattern.getSize()};
+        // the number of characters after the last line break
+        return {start.line + lineBreaks, static_cast<std::size_t>(std::find(begin, end, '\n') - begin)};
+    }
+
+    std::vector<Pos> Document::findAll(const sf::String &pattern) const {
+        std::vector<Pos> occurrences;
+        if (pattern.isEmpty()) return occurrences;
+
+        const Char *begin = pattern.getData();
+        const Char *end = begin + pattern.getSize();
+        const Char *firstBreak = std::find(begin, end, '\n');
+
+        if (firstBreak == end) {
+            // single line pattern -- searched within each line
+            std::boyer_moore_horspool_searcher<const Char *> searcher(begin, end);
+            for (std::size_t line = 0; line < getNumberLines(); line++) {
+                LineView view = getLineView(line);
+                const Char *position = view.begin();
+                while ((position = std::search(position, view.end(), searcher)) != view.end()) {
+                    occurrences.push_back({line, static_cast<std::size_t>(position - view.begin())});
+                    position += pattern.getSize();
+                }
+            }
+            return occurrences;
+        }
+
+        // split the pattern into the end of the first line, full lines and the start of the last line
+        std::vector<LineView> parts;
+        for (const Char *partBegin = begin;; partBegin++) {
+            const Char *partEnd = std::find(partBegin, end, '\n');
+            parts.emplace_back(partBegin, partEnd - partBegin);
+            if (partEnd == end) break;
+            partBegin = partEnd;
+        }
+
+        // occurrences may not start before the end of the previous occurrence
+        std::size_t minimumPosition = 0;
+        for (std::size_t line = 0; line + parts.size() - 1 < getNumberLines(); line++) {
+            auto matches = [this, &parts, line](std::size_t part) {
+                LineView view = getLineView(line + part);
+                const LineView &expected = parts[part];
+                if (part == 0) {
+                    return view.size() >= expected.size() &&
+                           std::equal(expected.begin(), expected.end(), view.end() - expected.size());
+                }
+                if (part == parts.size() - 1) {
+                    return view.size() >= expected.size() &&
+                           std::equal(expected.begin(), expected.end(), view.begin());
+                }
+                return std::equal(expected.begin(), expected.end(), view.begin(), view.end());
+            };
+
+            std::size_t start = getLineLength(line) - std::min(getLineLength(line), parts.front().size());
+            bool overlapsPrevious = start < minimumPosition;
+            minimumPosition = 0;
+            if (overlapsPrevious) continue;
+
+            std::size_t part = 0;
+            while (part < parts.size() && matches(part)) part++;
+            if (part == parts.size()) {
+                occurrences.push_back({line, start});
+                line += parts.size() - 2;
+                minimumPosition = parts.back().size();
+            }
+        }
+        return occurrences;
+    }
+
+    namespace {
+        // lines [oldStart, oldEnd) of the old text are replaced by lines [newStart, newEnd) of the new text
+        struct LineHunk {
+            std::size_t oldStart, oldEnd, newStart, newEnd;
+        };
+
+        std::uint64_t hashLine(const LineView &line) {
+            // FNV-1a
+            std::uint64_t hash = 14695981039346656037u;
+            for (Char c : line) {
+                hash = (hash ^ c) * 1099511628211u;
+            }
+            return hash;
+        }
+
+        // Myers' O((n + m) * d) diff of two sequences of n and m lines, where equal(i, j) compares line i of the first
+        // with line j of the second. nullopt if they differ by more than maxEdits inserted or removed lines
+        template<typename Equal>
+        std::optional<std::vector<LineHunk>> diffLines(std::size_t n, std::size_t m, Equal equal,
+                                                       std::size_t maxEdits) {
+            auto max = static_cast<std::ptrdiff_t>(std::min(n + m, maxEdits));
+            auto width = static_cast<std::ptrdiff_t>(n), height = static_cast<std::ptrdiff_t>(m);
+            // v[offset + k] is the furthest x reached on diagonal k = x - y
+            std::ptrdiff_t offset = max + 1;
+            std::vector<std::ptrdiff_t> v(2 * offset + 1, 0);
+            // v[offset - d - 1, offset + d + 1] before each step d, to trace the path back
+            std::vector<std::vector<std::ptrdiff_t>> trace;
+
+            std::optional<std::ptrdiff_t> edits;
+            for (std::ptrdiff_t d = 0; d <= max && !edits; d++) {
+                trace.emplace_back(v.begin() + offset - d - 1, v.begin() + offset + d + 2);
+                for (std::ptrdiff_t k = -d; k <= d; k += 2) {
+                    std::ptrdiff_t x = k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]) ?
+                                       v[offset + k + 1] : v[offset + k - 1] + 1;
+                    std::ptrdiff_t y = x - k;
+                    while (x < width && y < height && equal(x, y)) x++, y++;
+                    v[offset + k] = x;
+                    if (x >= width && y >= height) {
+                        edits = d;
+                        break;
+                    }
+                }
+            }
+            if (!edits) return std::nullopt;
+
+            // the matching lines, from the last
+            std::vector<std::pair<std::size_t, std::size_t>> matches;
+            std::ptrdiff_t x = width, y = height;
+            for (std::ptrdiff_t d = *edits; d >= 0; d--) {
+                const std::vector<std::ptrdiff_t> &previous = trace[d];
+                // previous[d + 1 + k] is v[offset + k]
+                auto at = [&previous, d](std::ptrdiff_t k) {
+                    return previous[d + 1 + k];
+                };
+                std::ptrdiff_t k = x - y;
+                std::ptrdiff_t previousK = k == -d || (k != d && at(k - 1) < at(k + 1)) ? k + 1 : k - 1;
+                std::ptrdiff_t previousX = d == 0 ? 0 : at(previousK);
+                std::ptrdiff_t previousY = d == 0 ? 0 : previousX - previousK;
+                while (x > previousX && y > previousY) {
+                    x--, y--;
+                    matches.emplace_back(x, y);
+                }
+                x = previousX;
+                y = previousY;
+            }
+
+            std::vector<LineHunk> hunks;
+            std::size_t oldLine = 0, newLine = 0;
+            for (auto match = matches.rbegin(); match != matches.rend(); match++) {
+                if (match->first != oldLine || match->second != newLine) {
+                    hunks.push_back({oldLine, match->first, newLine, match->second});
+                }
+                oldLine = match->first + 1;
+                newLine = match->second + 1;
+            }
+            if (oldLine != n || newLine != m) hunks.push_back({oldLine, n, newLine, m});
+            return hunks;
+        }
+    }
+
+    void Document::reloadText(const sf::String &content) {
+        SFTB_TRACE_SCOPE("reloadText");
+        // the lines of content, a text without line breaks has a single line
+        std::vector<LineView> newLines;
+        const Char *begin = content.getData(), *end = begin + content.getSize();
+        for (const Char *lineEnd; (lineEnd = std::find(begin, end, '\n')) != end; begin = lineEnd + 1) {
+            newLines.emplace_back(begin, lineEnd - begin);
+        }
+        newLines.emplace_back(begin, end - begin);
+        if (getNumberLines() == 0) {
+            if (!content.isEmpty()) insertText(getStartPos(), content);
+            return;
+        }
+
+        auto equalViews = [](const LineView &left, const LineView &right) {
+            return left.size() == right.size() && std::equal(left.begin(), left.end(), right.begin());
+        };
+        // lines kept at the start and end are not diffed, reloading a file changed in one place only compares lines
+        std::size_t oldLines = getNumberLines();
+        std::size_t prefix = 0;
+        while (prefix < oldLines && prefix < newLines.size() && equalViews(getLineView(prefix), newLines[prefix])) {
+            prefix++;
+        }
+        std::size_t suffix = 0;
+        while (suffix < oldLines - prefix && suffix < newLines.size() - prefix &&
+               equalViews(getLineView(oldLines - 1 - suffix), newLines[newLines.size() - 1 - suffix])) {
+            suffix++;
+        }
+        std::size_t oldCount = oldLines - prefix - suffix, newCount = newLines.size() - prefix - suffix;
+        if (oldCount == 0 && newCount == 0) return;
+
+        std::vector<std::uint64_t> oldHashes(oldCount), newHashes(newCount);
+        for (std::size_t line = 0; line < oldCount; line++) oldHashes[line] = hashLine(getLineView(prefix + line));
+        for (std::size_t line = 0; line < newCount; line++) newHashes[line] = hashLine(newLines[prefix + line]);
+        std::optional<std::vector<LineHunk>> hunks = diffLines(oldCount, newCount, [&](std::size_t i, std::size_t j) {
+            return oldHashes[i] == newHashes[j] && equalViews(getLineView(prefix + i), newLines[prefix + j]);
+        }, MAX_RELOAD_DIFF);
+        // too different to be worth diffing, the differing lines are replaced as a whole
+        if (!hunks) hunks = std::vector<LineHunk>{{0, oldCount, 0, newCount}};
+
+        // from the last hunk, so the lines of the hunks before it keep their index
+        for (auto hunk = hunks->rbegin(); hunk != hunks->rend(); hunk++) {
+            applyHunk(prefix + hunk->oldStart, prefix + hunk->oldEnd, newLines.data() + prefix + hunk->newStart,
+                      newLines.data() + prefix + hunk->newEnd);
+        }
+    }
+
+    void Document::applyHunk(std::size_t start, std::size_t end, const LineView *first, const LineView *last) {
+        EditScope scope(*this);
+        auto count = static_cast<std::size_t>(last - first);
+        if (count == 0) {
+            removeLines(start, end);
+            return;
+        }
+        if (start == end) {
+            // new lines, the lines around them are untouched
+            std::vector<Line> inserted;
+            inserted.reserve(count);
+            for (std::size_t i = 0; i < count; i++) inserted.emplace_back(this);
+            lines.insert(getLineIterator(start), std::make_move_iterator(inserted.begin()),
+                         std::make_move_iterator(inserted.end()));
+            for (std::size_t i = 0; i < count; i++) getLine(start + i).insert(first[i].begin(), first[i].end());
+            reportChange(start, 0, count);
+            return;
+        }
+
+        // replaces the characters of lines [start, end) which differ from [first, last), keeping the characters (and
+        // anchors) they start and end with
+        auto replaceLines = [this](std::size_t start, std::size_t end, const LineView *first, const LineView *last) {
+            LineView oldFirst = getLineView(start), oldLast = getLineView(end - 1);
+            const LineView &newFirst = *first, &newLast = *(last - 1);
+            std::size_t common = std::min(oldFirst.size(), newFirst.size());
+            const Char *mismatch = std::mismatch(oldFirst.begin(), oldFirst.begin() + common, newFirst.begin()).first;
+            auto prefix = static_cast<std::size_t>(mismatch - oldFirst.begin());
+            // the suffix does not overlap the prefix within a single line
+            std::size_t maxSuffix = std::min(end - start == 1 ? oldLast.size() - prefix : oldLast.size(),
+                                             last - first == 1 ? newLast.size() - prefix : newLast.size());
+            std::size_t suffix = 0;
+            while (suffix < maxSuffix && oldLast[oldLast.size() - 1 - suffix] == newLast[newLast.size() - 1 - suffix]) {
+                suffix++;
+            }
+
+            std::basic_string<Char> text;
+            for (const LineView *line = first; line != last; line++) {
+                std::size_t from = line == first ? prefix : 0;
+                std::size_t to = line == last - 1 ? line->size() - suffix : line->size();
+                if (line != first) text += '\n';
+                text.append(line->begin() + from, line->begin() + to);
+            }
+            replaceText({start, prefix}, {end - 1, oldLast.size() - suffix}, text);
+        };
+
+        if (end - start == count) {
+            // modified lines, each keeps the anchors of its unchanged characters
+            for (std::size_t i = 0; i < count; i++) replaceLines(start + i, start + i + 1, first + i, first + i + 1);
+        } else replaceLines(start, end, first, last);
+    }
+
+    std::size_t Document::getMemoryEstimate() const {
+        // approximate size of a node of lineLength
+        constexpr std::size_t LINE_LENGTH_NODE_SIZE = sizeof(Line **) + 4 * sizeof(void *);
+        // a character, its anchor and its advance offset once laid out
+        constexpr std::size_t CHARACTER_SIZE = sizeof(Char) + sizeof(CharInfo) + sizeof(float);
+
+        // derived from the counts kept up to date by each edit, so the estimate can be read every frame
+        return sizeof(Document) + lines.capacity() * sizeof(Line) +
+               getNumberLines() * (sizeof(Line *) + LINE_LENGTH_NODE_SIZE) + numberCharacters * CHARACTER_SIZE;
+    }
+
+    DocumentSnapshot Document::getSnapshot() const {
+        SFTB_TRACE_SCOPE("getSnapshot");
+        SnapshotChunks &tracked = snapshotChunks;
+        std::shared_ptr<const detail::SnapshotData> last = tracked.last.lock();
+        if (last && !tracked.anyChanged) return DocumentSnapshot(std::move(last));
+
+        auto data = std::make_shared<detail::SnapshotData>();
+        std::size_t line = 0;
+        // adds lines [line, end) of the document in new chunks
+        auto addLines = [this, &data, &line](std::size_t end) {
+            while (line < end) {
+                auto chunk = std::make_shared<detail::SnapshotChunk>();
+                std::size_t chunkEnd = std::min(end, line + SNAPSHOT_CHUNK_LINES);
+                data->chunkStarts.push_back(line);
+                chunk->lines.reserve(chunkEnd - line);
+                for (; line < chunkEnd; line++) {
+                    chunk->lines.push_back(getLine(line).getSharedText());
+                }
+                data->chunks.push_back(std::move(chunk));
+            }
+        };
+
+        if (!last || tracked.rebuild) {
+            addLines(getNumberLines());
+        } else {
+            // unchanged chunks are shared, consecutive changed chunks are rebuilt together so they do not fragment
+            std::size_t changedEnd = 0;
+            for (std::size_t chunk = 0; chunk < tracked.changed.size(); chunk++) {
+                std::size_t count = tracked.lines.get(chunk);
+                if (tracked.changed[chunk]) {
+                    changedEnd += count;
+                    continue;
+                }
+                addLines(changedEnd);
+                assert(last->chunks[chunk]->lines.size() == count && "unchanged chunk changed size");
+                data->chunkStarts.push_back(line);
+                data->chunks.push_back(last->chunks[chunk]);
+                line += count;
+                changedEnd = line;
+            }
+            addLines(changedEnd);
+        }
+        assert(line == getNumberLines() && "snapshot lines do not match the document");
+        data->numberLines = getNumberLines();
+        data->numberCharacters = numberCharacters;
+
+        tracked.lines.build(data->chunks.size(), [&data](std::size_t chunk) {
+            return data->chunks[chunk]->lines.size();
+        });
+        tracked.changed.assign(data->chunks.size(), false);
+        tracked.anyChanged = false;
+        tracked.rebuild = false;
+        tracked.last = data;
+        return DocumentSnapshot(std::move(data));
+    }
+
+    namespace detail {
+        void Line::remove(std::size_t start, std::size_t end) {
+            auto endIndex = std::min(end, getNumberCharacters());
+            auto iterStart = characters.begin() + start;
+            auto iterEnd = characters.begin() + endIndex;
+            if (mayHaveAnchors) prepareRemove(getTransferPos(start, endIndex), iterStart, iterEnd);
+
+            characters.erase(iterStart, iterEnd);
+            if (start != endIndex) {
+                LineText &lineText = getMutableText();
+                lineText.erase(lineText.begin() + start, lineText.begin() + endIndex);
+            }
+            getDocument().numberCharacters -= endIndex - start;
+            updateLineLength(start);
+        }
+
+        void Line::remove(const std::vector<std::pair<std::size_t, std::size_t>> &ranges) {
+            if (ranges.empty()) return;
+            assert(ranges.back().second <= getNumberCharacters() && "range out of bounds");
+            // each range transfers its anchors to a character kept before (or after) it
+            if (mayHaveAnchors) {
+                for (auto [start, end] : ranges) {
+                    prepareRemove(getTransferPos(start, end), characters.begin() + start, characters.begin() + end);
+                }
+            }
+
+            // the characters between each range and the next are moved to their final index
+            LineText &lineText = getMutableText();
+            std::size_t destination = ranges.front().first;
+            for (std::size_t i = 0; i < ranges.size(); i++) {
+                assert(ranges[i].first < ranges[i].second && (i == 0 || ranges[i - 1].second < ranges[i].first) &&
+                       "ranges are not sorted, separated and non empty");
+                std::size_t next = i + 1 < ranges.size() ? ranges[i + 1].first : getNumberCharacters();
+                std::move(lineText.begin() + ranges[i].second, lineText.begin() + next, lineText.begin() + destination);
+                std::move(characters.begin() + ranges[i].second, characters.begin() + next,
+                          characters.begin() + destination);
+                destination += next - ranges[i].second;
+            }
+
+            getDocument().numberCharacters -= getNumberCharacters() - destination;
+            lineText.resize(destination);
+            characters.erase(characters.begin() + destination, characters.end());
+            updateLineLength(ranges.front().first);
+        }
+
+        CharPos Line::getTransferPos(std::size_t start, std::size_t end) {
+            CharPos transferPos;
+
+            if (start == 0) {
+                auto lineIndex = getDocument().getLineIndex(this);
+                if (lineIndex == 0) {
+                    // end character if exists, or end of line
+                    transferPos = getDocument().getCharPos({lineIndex, end});
+                } else {
+                    Line &previousLine = getDocument().getLine(lineIndex - 1);
+                    transferPos = previousLine.endLineCharPosDataHolder.getCharPos(&previousLine, nullptr);
+                }
+            } else {
+                CharInfo &info = characters[start - 1];
+                transferPos = info.referenceHolder.getCharPos(this, &info);
+            }
+            return transferPos;
+        }
+
+        void Line::move(Line &line, std::size_t start, std::size_t insertPosition) {
+            assert(start <= getNumberCharacters() && "start out of bounds");
+            assert(insertPosition <= line.getNumberCharacters() && "insert position out of bounds");
+            // todo - clean up
+
+            // move characters (at and after start) to other line at insertPosition
+            auto iterFirstCharacter = characters.begin() + start;
+            auto iterLastCharacter = characters.end();
+            bool moveText = start < characters.size();
+
+            if (mayHaveAnchors) line.mayHaveAnchors = true;
+            // update character line
+            auto iter = iterFirstCharacter;
+            while (iter < characters.end()) {
+                iter->referenceHolder.updateLine(line);
+                iter++;
+            }
+
+            line.characters.insert(line.characters.begin() + insertPosition,
+                                   std::make_move_iterator(iterFirstCharacter),
+                                   std::make_move_iterator(iterLastCharacter));
+            characters.erase(iterFirstCharacter, iterLastCharacter);
+            if (moveText && start == 0 && !line.text) {
+                // the whole text moves to an empty line, which takes its buffer
+                line.text = std::move(text);
+            } else if (moveText) {
+                LineText &lineText = getMutableText();
+                LineText &otherText = line.getMutableText();
+                otherText.insert(otherText.begin() + insertPosition, lineText.begin() + start, lineText.end());
+                lineText.erase(lineText.begin() + start, lineText.end());
+            }
+            line.updateLineLength(insertPosition);
+            updateLineLength(start);
+        }
+
+        void Line::insert(const Char *first, const Char *last, std::size_t index) {
+            assert(index <= getNumberCharacters() && "index out of bounds");
+            if (first != last) {
+                LineText &lineText = getMutableText();
+                lineText.insert(lineText.begin() + index, first, last);
+            }
+
+            // make room for the new characters with a single shift; moving a CharInfo updates its anchor
+            std::size_t previousSize = characters.size();
+            characters.resize(previousSize + (last - first));
+            std::move_backward(characters.begin() + index, characters.begin() + previousSize, characters.end());
+            getDocument().numberCharacters += last - first;
+            updateLineLength(index);
+        }
+
+        void Line::insert(const std::vector<std::size_t> &positions, const Char *first, const Char *last) {
+            assert(std::is_sorted(positions.begin(), positions.end()) && "positions are not sorted");
+            if (positions.empty()) return;
+            assert(positions.back() <= getNumberCharacters() && "position out of bounds");
+
+            auto count = static_cast<std::size_t>(last - first);
+            std::size_t source = getNumberCharacters();
+            std::size_t destination = source + positions.size() * count;
+            LineText &lineText = getMutableText();
+            lineText.resize(destination);
+            characters.resize(destination);
+
+            // from the last position to the first, move the characters after the position to their final index, then
+            // insert the text before them
+            for (auto position = positions.rbegin(); position != positions.rend(); position++) {
+                std::move_backward(lineText.begin() + *position, lineText.begin() + source,
+                                   lineText.begin() + destination);
+                std::move_backward(characters.begin() + *position, characters.begin() + source,
+                                   characters.begin() + destination);
+                destination -= source - *position + count;
+                std::copy(first, last, lineText.begin() + destination);
+                source = *position;
+            }
+
+            getDocument().numberCharacters += positions.size() * count;
+            updateLineLength(positions.front());
+        }
+
+        LineText &Line::getMutableText() {
+            if (!text) {
+                text = std::make_shared<LineText>();
+            } else if (text.use_count() > 1) {
+                text = std::make_shared<LineText>(*text);
+            } else {
+                // the count may have dropped to 1 on another thread, which must be done reading the text
+                std::atomic_thread_fence(std::memory_order_acquire);
+            }
+            return *text;
+        }
+
+        void Line::prepareRemove(const CharPos &transferPos, const std::vector<CharInfo>::iterator &start,
+                                 const std::vector<CharInfo>::iterator &end) {
+            for (auto iter = start; iter < end; iter++) {
+                iter->referenceHolder.transfer(transferPos);
+            }
+        }
+    }
+}
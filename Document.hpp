@@ -0,0 +1,666 @@
+#ifndef SFML_TEXTBOX_DOCUMENT_HPP
+#define SFML_TEXTBOX_DOCUMENT_HPP
+
+#include <SFML/System/String.hpp>
+#include <vector>
+#include <set>
+#include <memory>
+#include <optional>
+#include <string>
+#include <algorithm>
+#include <cassert>
+#include "CharPos.hpp"
+#include "InputHandler.hpp"
+#include "Reference.hpp"
+#include "Pos.hpp"
+#include "GlyphMetrics.hpp"
+#include "Utf8.hpp"
+#include "Stats.hpp"
+#include "FenwickTree.hpp"
+
+namespace sftb {
+    class TextBox;
+
+    namespace detail {
+        class CharPosDataHolder {
+        private:
+            std::weak_ptr<CharPosData> reference;
+
+        public:
+            CharPosDataHolder() = default;
+            CharPosDataHolder(const CharPosDataHolder &) = delete;
+            CharPosDataHolder &operator=(const CharPosDataHolder &) = delete;
+            CharPosDataHolder(CharPosDataHolder &&) = default;
+            CharPosDataHolder &operator=(CharPosDataHolder &&) = default;
+
+            ~CharPosDataHolder() {
+                assert(!active() && "CharPosDataHolder info was not transferred");
+            }
+
+            void transfer(const CharPos &pos);
+
+            [[nodiscard]] bool active() const {
+                return !reference.expired();
+            }
+
+            void updateLine(Line &line);
+            void updateCharInfo(CharInfo *info);
+            CharPos getCharPos(Line *line, CharInfo *info);
+        };
+
+        class Line;
+
+        // the characters of a line, shared with the DocumentSnapshots taken since it was last modified
+        using LineText = std::vector<Char>;
+
+        struct SnapshotData;
+    }
+
+    class DocumentSnapshot;
+
+    /**
+     * Read-only view of (part of) a single line. The view refers to the line's storage directly, so it is
+     * invalidated by any modification of the line.
+     */
+    class LineView {
+    private:
+        const Char *first = nullptr;
+        std::size_t length = 0;
+
+    public:
+        LineView() = default;
+
+        LineView(const Char *first, std::size_t length) : first(first), length(length) {}
+
+        [[nodiscard]] const Char *data() const {
+            return first;
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return length;
+        }
+
+        [[nodiscard]] bool empty() const {
+            return length == 0;
+        }
+
+        [[nodiscard]] const Char *begin() const {
+            return first;
+        }
+
+        [[nodiscard]] const Char *end() const {
+            return first + length;
+        }
+
+        Char operator[](std::size_t index) const {
+            assert(index < length && "index out of bounds");
+            return first[index];
+        }
+    };
+
+    // lines [line, line + removedLines) of a Document were replaced by lines [line, line + insertedLines)
+    // lines whose contents changed are reported as replaced, so the ranges may overlap lines which were kept
+    struct DocumentChange {
+        std::size_t line = 0;
+        std::size_t removedLines = 0;
+        std::size_t insertedLines = 0;
+    };
+
+    class DocumentListener {
+    public:
+        virtual ~DocumentListener() = default;
+
+        // called once per edit, after the edit is complete. Listeners must not be removed while being notified
+        virtual void onDocumentChange(const DocumentChange &change) = 0;
+    };
+
+    /**
+     * The text displayed by a TextBox: its lines, and the anchors (CharPos) of its characters.
+     * Several TextBoxes may display and edit the same Document, such as split panes of one file, each with its own
+     * scrolling, carets and highlights (see TextBox::TextBox(std::shared_ptr<Document>, ...)). Every edit notifies the
+     * document's listeners once, with the range of lines it affected.
+     *
+     * A document can be limited to a number of lines or characters, such as a log console which keeps the latest
+     * output, see append(). Removing lines from the start of the document is O(1) amortized per line (besides the
+     * anchors of the lines, if any).
+     */
+    class Document : public Reference<Document> {
+        friend class detail::Line;
+        friend class TextBox;
+    private:
+        using Line = detail::Line;
+        using CharPosDataHolder = detail::CharPosDataHolder;
+        using CharPosData = detail::CharPosData;
+        using CharInfo = detail::CharInfo;
+
+        struct LineLengthCompare {
+            bool operator()(Line **left, Line **right) const;
+        };
+
+        using LineLengthSet = std::multiset<Line **, LineLengthCompare>;
+
+        // glyph metrics and tab size lines have been laid out with, see getLayoutId()
+        struct Layout {
+            std::weak_ptr<const GlyphMetrics> metrics;
+            unsigned tabSize;
+            unsigned id;
+        };
+
+        LineLengthSet lineLength;
+        // the lines of the document start at firstLine; the lines before it were removed from the start of the document
+        // and are empty, so removing lines from the start does not shift the following lines (see removeLines())
+        std::vector<Line> lines;
+        std::size_t firstLine = 0;
+        // characters of all lines, not including line breaks
+        std::size_t numberCharacters = 0;
+        // 0 for no limit, see append()
+        std::size_t maxLines = 0;
+        std::size_t maxCharacters = 0;
+        CharPosDataHolder endCharPosDataHolder;
+        std::vector<Layout> layouts;
+        unsigned nextLayoutId = 1;
+        std::vector<DocumentListener *> listeners;
+        // lines affected by the edit in progress, reported once the outermost edit ends
+        std::optional<DocumentChange> pendingChange;
+        // number of edits in progress, edits made by other edits are reported as part of the outermost edit
+        unsigned editDepth = 0;
+
+        // lines per block of LineOffsets when it is built, a block is split once it has more than twice as many
+        static constexpr std::size_t LINE_OFFSETS_BLOCK = 64;
+
+        // the lines in blocks of consecutive lines, see posToOffset(). Built by the first conversion, then kept up to
+        // date by reportChange(), which sums the lengths of the blocks containing a change again
+        struct LineOffsets {
+            // number of lines in each block
+            detail::FenwickTree<std::size_t> lines;
+            // length of the lines of each block plus their line breaks
+            detail::FenwickTree<std::size_t> characters;
+            bool valid = false;
+        };
+
+        mutable LineOffsets lineOffsets;
+        // lines getRelativeCharacters() walks before using lineOffsets, short moves do not need them
+        static constexpr std::size_t RELATIVE_CHARACTERS_WALK = 8;
+
+        // lines inserted or removed beyond which reloadText() replaces the differing lines rather than diffing them
+        static constexpr std::size_t MAX_RELOAD_DIFF = 1024;
+
+        // lines per chunk of a snapshot, see getSnapshot()
+        static constexpr std::size_t SNAPSHOT_CHUNK_LINES = 256;
+
+        // the chunks of the last snapshot, and which of them changed since it was taken. Only tracked while the
+        // snapshot is held elsewhere, so the document does not keep replaced lines alive
+        struct SnapshotChunks {
+            std::weak_ptr<const detail::SnapshotData> last;
+            // number of lines now in the range of each chunk
+            detail::FenwickTree<std::size_t> lines;
+            std::vector<bool> changed;
+            bool anyChanged = false;
+            // the changes could not be attributed to chunks (the last snapshot had none), no chunk is shared
+            bool rebuild = false;
+        };
+
+        mutable SnapshotChunks snapshotChunks;
+
+        // adds a change, in the coordinates of the lines after the changes reported so far, to pendingChange
+        void reportChange(std::size_t line, std::size_t removedLines, std::size_t insertedLines);
+        void updateLineOffsets(std::size_t line, std::size_t removedLines, std::size_t insertedLines);
+        void ensureLineOffsets() const;
+        // splits the blocks of lineOffsets with too many lines, and merges neighbouring blocks with few
+        void compactLineOffsets();
+        // length of lines [start, end) plus their line breaks
+        [[nodiscard]] std::size_t getLinesLength(std::size_t start, std::size_t end) const;
+        // marks the chunks of the last snapshot containing a reported change as changed
+        void trackSnapshotChange(std::size_t line, std::size_t removedLines, std::size_t insertedLines);
+        void notifyListeners();
+
+        Line &getLine(std::size_t line) {
+            assert(line < getNumberLines() && "line out of bounds");
+            return lines[firstLine + line];
+        }
+
+        [[nodiscard]] std::vector<Line>::iterator getLineIterator(std::size_t line) {
+            return lines.begin() + static_cast<std::ptrdiff_t>(firstLine + line);
+        }
+
+        const Line &getLine(std::size_t line) const {
+            return const_cast<Document *>(this)->getLine(line);
+        }
+
+        Line &getOrInsertLine(std::size_t line);
+
+        [[nodiscard]] std::size_t getLineIndex(const Line *line) const;
+
+        // the line with the most characters, nullptr if there are no lines
+        [[nodiscard]] const Line *getLongestLine() const;
+
+        // identifies the layout of lines with metrics and tabSize, TextBoxes with the same font, character size and tab
+        // size share the layout of each line
+        unsigned getLayoutId(const std::shared_ptr<const GlyphMetrics> &metrics, unsigned tabSize);
+
+        // removes lines from the start of the document while it exceeds maxLines or maxCharacters, keeping the last line
+        void applyLimits();
+
+        // replaces lines [start, end) with the lines [first, last), as a single edit
+        void applyHunk(std::size_t start, std::size_t end, const LineView *first, const LineView *last);
+
+        CharPos getTransferPos(std::size_t start, std::size_t end) {
+            return start == 0 ? getCharPos({end, getLineLength(end)}) :
+                   getCharPos({start - 1, getLineLength(start - 1)});
+        }
+
+        // calls f(view, lineBreak) for each line between first and second (ordered), lineBreak is true for all but the
+        // last line
+        template<typename F>
+        void forEachLineView(Pos first, Pos second, F f) const;
+
+    public:
+        Document() = default;
+
+        // TextBoxes and CharPos refer to the document, it is shared rather than copied or moved
+        Document(const Document &) = delete;
+        Document &operator=(const Document &) = delete;
+        Document(Document &&) = delete;
+        Document &operator=(Document &&) = delete;
+
+        // the edits made while a scope exists are reported to the listeners as a single change once the outermost scope
+        // ends, so several edits update the TextBoxes once
+        class EditScope {
+        private:
+            Document &document;
+        public:
+            explicit EditScope(Document &document) : document(document) {
+                document.editDepth++;
+            }
+
+            EditScope(const EditScope &) = delete;
+            EditScope &operator=(const EditScope &) = delete;
+
+            ~EditScope() {
+                if (--document.editDepth == 0) document.notifyListeners();
+            }
+        };
+
+        // listener must be removed before it is destroyed
+        void addListener(DocumentListener *listener) {
+            assert(listener != nullptr && "listener is nullptr");
+            listeners.push_back(listener);
+        }
+
+        void removeListener(DocumentListener *listener) {
+            listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+        }
+
+        [[nodiscard]] std::size_t getNumberLines() const {
+            return lines.size() - firstLine;
+        }
+
+        // not including line breaks
+        [[nodiscard]] std::size_t getNumberCharacters() const {
+            return numberCharacters;
+        }
+
+        [[nodiscard]] std::size_t getLineLength(std::size_t line) const;
+        [[nodiscard]] std::size_t getLongestLineLength() const;
+
+        [[nodiscard]] Pos getStartPos() const {
+            // included to make code more readable
+            return {0, 0};
+        }
+
+        [[nodiscard]] Pos getEndPos() const {
+            return {getNumberLines(), 0};
+        }
+
+        CharPos getCharPos(const Pos &pos);
+
+        [[nodiscard]] Pos getPositionOfChar(const CharPos &pos) const {
+            assert(pos && "empty CharPos");
+            const CharPosData::Absolute &absolute = pos->getLinkedAbsolute();
+            return absolute.line == nullptr ? getEndPos() : Pos{getLineIndex(*absolute.line), pos->getCharacterIndex()};
+        }
+
+        // moves across a few lines are walked, longer ones cost about as much as posToOffset()
+        [[nodiscard]] Pos getRelativeCharacters(Pos pos, int characters) const;
+
+        // number of characters before pos, counting each line break as a character (as getTextFrom() does)
+        // O(log(number of lines) + LINE_OFFSETS_BLOCK), the lines are summed in blocks of about LINE_OFFSETS_BLOCK
+        [[nodiscard]] std::size_t posToOffset(Pos pos) const;
+        // the position offset characters after the start of the document, getEndPos() if offset is beyond it
+        [[nodiscard]] Pos offsetToPos(std::size_t offset) const;
+        [[nodiscard]] Pos getRelativeLine(Pos pos, int lineAmount) const;
+
+        [[nodiscard]] sf::String getTextFrom(Pos first, Pos second) const;
+        [[nodiscard]] sf::String getLineContents(std::size_t line, std::size_t start = 0, std::size_t end = -1) const;
+
+        // the characters of line between start and end, without copying
+        [[nodiscard]] LineView getLineView(std::size_t line, std::size_t start = 0, std::size_t end = -1) const;
+        // exact number of characters between first and second, including line breaks
+        [[nodiscard]] std::size_t getTextSize(Pos first, Pos second) const;
+        // writes the characters between first and second to out (line breaks as '\n'), returns the end of the output
+        // getTextSize() characters are written, so out may point into a buffer of that size
+        template<typename OutputIt>
+        OutputIt copyText(Pos first, Pos second, OutputIt out) const;
+
+        // exact number of bytes of the UTF-8 encoding of the text between first and second
+        [[nodiscard]] std::size_t getTextSizeUtf8(Pos first, Pos second) const;
+        template<typename OutputIt>
+        OutputIt copyTextUtf8(Pos first, Pos second, OutputIt out) const;
+        [[nodiscard]] std::string getTextUtf8(Pos first, Pos second) const;
+
+        Pos insertText(Pos pos, const sf::String &text);
+        // inserts text at each of the sorted, unique positions in a single pass, each affected line is rebuilt once
+        // returns the end of each insertion, in the same order as positions
+        std::vector<Pos> insertText(const std::vector<Pos> &positions, const sf::String &text);
+        Pos insertLine(unsigned line, const sf::String &string = "");
+        void removeText(Pos from, Pos to);
+        // removes the text of each range (in either order) as a single edit. Ranges may overlap and be in any order,
+        // those within a line are removed in a single pass over the line
+        // returns the start of each range after the removal, in the same order as ranges
+        std::vector<Pos> removeText(const std::vector<std::pair<Pos, Pos>> &ranges);
+
+        Pos replaceText(const Pos &from, const Pos &to, const sf::String &text) {
+            EditScope scope(*this);
+            removeText(from, to);
+            return insertText(from, text);
+        }
+
+        void removeLine(unsigned line);
+        // removing lines from the start of the document (start is 0) does not move the following lines
+        void removeLines(unsigned start, unsigned end);
+
+        // inserts text at the end of the last line, then removes lines from the start of the document while it has more
+        // than getMaxLines() lines or getMaxCharacters() characters (the last line is always kept). Anchors within the
+        // removed lines move to the end of the first remaining line, as with removeLines()
+        // O(1) amortized per line added or removed, besides the characters of text
+        Pos append(const sf::String &text);
+
+        [[nodiscard]] std::size_t getMaxLines() const {
+            return maxLines;
+        }
+
+        // lines are removed as needed by append() and by this function, 0 for no limit
+        void setMaxLines(std::size_t lines) {
+            maxLines = lines;
+            applyLimits();
+        }
+
+        [[nodiscard]] std::size_t getMaxCharacters() const {
+            return maxCharacters;
+        }
+
+        // not including line breaks, lines are removed as needed by append() and by this function, 0 for no limit
+        void setMaxCharacters(std::size_t characters) {
+            maxCharacters = characters;
+            applyLimits();
+        }
+
+        // replaces the text of the document with content, such as a file which changed on disk. Only the lines which
+        // differ are edited (found with a line diff), each run of differing lines as a separate edit, so the unchanged
+        // lines keep their anchors and layout, and listeners only handle the changed lines. Within a modified line,
+        // the unchanged characters at its start and end are kept as well
+        void reloadText(const sf::String &content);
+
+        // start of each (non overlapping) occurrence of pattern, which may span several lines
+        [[nodiscard]] std::vector<Pos> findAll(const sf::String &pattern) const;
+        // end of an occurrence of pattern starting at start
+        [[nodiscard]] static Pos getEndOf(const Pos &start, const sf::String &pattern);
+
+        // estimated number of bytes used by the text, anchors and layout of the lines, O(1). Spare capacity and the
+        // layouts of other TextBoxes sharing the document are not counted
+        [[nodiscard]] std::size_t getMemoryEstimate() const;
+
+        // the text of the document as it is now, which may be read by other threads while the document is edited
+        // While the previous snapshot is still held, its chunks of SNAPSHOT_CHUNK_LINES lines are shared unless one of
+        // their lines changed, so a snapshot costs O(number of lines / SNAPSHOT_CHUNK_LINES) besides the lines changed
+        // since the previous one, and O(1) if none changed. Otherwise it costs O(number of lines). Must be called by the
+        // thread editing the document
+        [[nodiscard]] DocumentSnapshot getSnapshot() const;
+    };
+
+    namespace detail {
+        // anchor of a single character, the character itself is stored separately in Line::text
+        class CharInfo {
+            friend class sftb::Document;
+            friend class detail::Line;
+        private:
+            CharPosDataHolder referenceHolder;
+        public:
+            CharInfo() = default;
+
+            // while copying could be implemented, there is currently no intended
+            // reason to copy CharInfo. Operators are deleted for safety.
+            CharInfo(const CharInfo &) = delete;
+            CharInfo &operator=(const CharInfo &) = delete;
+
+            CharInfo(CharInfo &&other) noexcept: referenceHolder(std::move(other.referenceHolder)) {
+                referenceHolder.updateCharInfo(this);
+            }
+
+            CharInfo &operator=(CharInfo &&other) noexcept {
+                referenceHolder = std::move(other.referenceHolder);
+                referenceHolder.updateCharInfo(this);
+
+                return *this;
+            }
+        };
+
+        class Line : public Reference<Line> {
+            friend class sftb::Document;
+            friend class CharPosData;
+            friend class CharPosDataHolder;
+        private:
+            using Document = sftb::Document;
+            using TextBox = sftb::TextBox;
+
+            Document **document;
+            Document::LineLengthSet::iterator lineLengthIterator;
+            // characters are stored contiguously, separate from their anchors, so they can be viewed and copied in bulk
+            // (*text)[i] is the character of characters[i]. Copied on write while a snapshot shares it (see
+            // getMutableText()), nullptr until the line has characters
+            std::shared_ptr<LineText> text;
+            std::vector<CharInfo> characters;
+            CharPosDataHolder endLineCharPosDataHolder;
+            // horizontal offset of each character (prefix sums of glyph advances, including kerning), followed by the
+            // width of the line once the whole line has been laid out. Lines are laid out lazily, in chunks, up to the
+            // last character used; modifying the line discards the offsets at and after the first modified character
+            mutable std::vector<float> advanceOffsets;
+            // Document::getLayoutId() of the TextBox advanceOffsets were laid out for
+            mutable unsigned layoutId = 0;
+            // advance offsets of the other layouts the line was laid out with, most recently used first, so TextBoxes
+            // with different layouts do not lay the line out again in turn. See useLayout()
+            mutable std::vector<std::pair<unsigned, std::vector<float>>> otherLayouts;
+            // false if no CharPos was created for the line or its characters, removing characters then skips their
+            // anchors. Set when an anchor is created in the line or characters with anchors are moved into it
+            bool mayHaveAnchors = false;
+
+            auto createIterator() {
+                return getDocument().lineLength.insert(getReference());
+            }
+
+            void removeIterator() {
+                getDocument().lineLength.erase(lineLengthIterator);
+            }
+
+            // the position anchors within [start, end) are moved to when the characters are removed
+            CharPos getTransferPos(std::size_t start, std::size_t end);
+
+            static void prepareRemove(const CharPos &transferPos, const std::vector<CharInfo>::iterator &start,
+                                      const std::vector<CharInfo>::iterator &end);
+
+            // text, copied first if a snapshot shares it
+            LineText &getMutableText();
+
+            // makes the offsets of layout id current, keeping the current ones in otherLayouts
+            void useLayout(unsigned id) const;
+        public:
+            explicit Line(Document *document) : document(document->getReference()),
+                                                lineLengthIterator(createIterator()) {}
+
+            ~Line() {
+                if (document)
+                    removeIterator();
+            }
+
+            Line(const Line &) = delete;
+            Line &operator=(const Line &) = delete;
+
+            Line(Line &&other) noexcept: Reference(std::move(other)), document(other.document), lineLengthIterator(std::move(other.lineLengthIterator)), text(std::move(other.text)), characters(std::move(other.characters)),
+                                         endLineCharPosDataHolder(std::move(other.endLineCharPosDataHolder)), advanceOffsets(std::move(other.advanceOffsets)),
+                                         layoutId(other.layoutId), otherLayouts(std::move(other.otherLayouts)), mayHaveAnchors(other.mayHaveAnchors) {
+                other.document = nullptr;
+                SFTB_STATS_INCREMENT(linesMoved);
+            }
+
+            Line &operator=(Line &&other) noexcept {
+                if(&other != this) {
+                    Reference::operator=(std::move(other));
+                    if(document)
+                    removeIterator();
+                    document = other.document;
+                    other.document = nullptr;
+                    lineLengthIterator = std::move(other.lineLengthIterator);
+                    text = std::move(other.text);
+                    characters = std::move(other.characters);
+                    endLineCharPosDataHolder = std::move(other.endLineCharPosDataHolder);
+                    advanceOffsets = std::move(other.advanceOffsets);
+                    layoutId = other.layoutId;
+                    otherLayouts = std::move(other.otherLayouts);
+                    mayHaveAnchors = other.mayHaveAnchors;
+                    SFTB_STATS_INCREMENT(linesMoved);
+                }
+                return *this;
+            }
+
+            inline Document &getDocument() {
+                assert(document != nullptr && "line is invalid");
+                return **document;
+            }
+
+            [[nodiscard]] inline const Document &getDocument() const {
+                assert(document != nullptr && "line is invalid");
+                return **document;
+            }
+
+            // changedFrom is the first character which was modified
+            void updateLineLength(std::size_t changedFrom = 0) {
+                if (advanceOffsets.size() > changedFrom) advanceOffsets.resize(changedFrom);
+                for (auto &[id, offsets] : otherLayouts) {
+                    if (offsets.size() > changedFrom) offsets.resize(changedFrom);
+                }
+                // reinsert the existing node rather than allocating a new one, this is called for every edit
+                Document::LineLengthSet &set = getDocument().lineLength;
+                lineLengthIterator = set.insert(set.extract(lineLengthIterator));
+                SFTB_STATS_INCREMENT(lineLengthUpdates);
+            }
+
+            // the layout functions lay the line out with the font and tab size of view
+            // ensures advanceOffsets contains position (or the width of the line, if position is the end of the line)
+            // The offsets are prefix sums, so the line is always laid out from its start: the first layout of a position
+            // far into a long line, and the first after an edit before it, cost O(position) rather than O(LAYOUT_CHUNK)
+            void layoutUntil(const TextBox &view, std::size_t position) const;
+
+            // only valid after layoutUntil()
+            [[nodiscard]] bool isLaidOut() const {
+                return advanceOffsets.size() == characters.size() + 1;
+            }
+
+            // estimated for lines of at least TextBox::getLongLineLength() characters which have not been fully laid out
+            [[nodiscard]] float getWidth(const TextBox &view) const;
+
+            // O(1) once the line has been laid out
+            [[nodiscard]] float getOffset(const TextBox &view, std::size_t position) const;
+            // binary search over the advance offsets
+            [[nodiscard]] std::size_t getPositionAt(const TextBox &view, float offset, float round) const;
+
+            // only valid after layoutUntil(view, getNumberCharacters())
+            [[nodiscard]] const std::vector<float> &getAdvanceOffsets() const {
+                return advanceOffsets;
+            }
+
+            [[nodiscard]] std::size_t getNumberCharacters() const {
+                assert(document != nullptr && "line is invalid");
+                return characters.size();
+            }
+
+            void insert(const Char *first, const Char *last, std::size_t index = 0);
+
+            void insert(const sf::String &string, std::size_t index = 0) {
+                insert(string.getData(), string.getData() + string.getSize(), index);
+            }
+
+            // inserts [first, last) at each of the sorted positions, shifting every character at most once
+            void insert(const std::vector<std::size_t> &positions, const Char *first, const Char *last);
+
+            void prepareRemoveAll(const CharPos &transferPos) {
+                assert(document != nullptr && "line is invalid");
+                if (mayHaveAnchors) prepareRemove(transferPos, characters.begin(), characters.end());
+                endLineCharPosDataHolder.transfer(transferPos);
+            }
+
+            void remove(std::size_t start, std::size_t end = -1);
+            // removes the sorted ranges [start, end), separated by at least one character, shifting every character at
+            // most once
+            void remove(const std::vector<std::pair<std::size_t, std::size_t>> &ranges);
+            void move(Line &line, std::size_t start, std::size_t insertPosition);
+
+            [[nodiscard]] Char getChar(std::size_t position) const {
+                assert(position < getNumberCharacters() && "position out of bounds");
+                return (*text)[position];
+            }
+
+            [[nodiscard]] const Char *getText() const {
+                return text ? text->data() : nullptr;
+            }
+
+            // the text as it is now, unaffected by later modifications of the line. nullptr if the line is empty
+            [[nodiscard]] std::shared_ptr<const LineText> getSharedText() const {
+                return text;
+            }
+
+            CharInfo &getCharInfo(std::size_t position) {
+                assert(position < getNumberCharacters() && "position out of bounds");
+                return characters[position];
+            }
+
+            [[nodiscard]] const CharInfo &getCharInfo(std::size_t position) const {
+                return const_cast<Line *>(this)->getCharInfo(position);
+            }
+        };
+    }
+
+    template<typename F>
+    void Document::forEachLineView(Pos first, Pos second, F f) const {
+        if (second < first) std::swap(first, second);
+        if (first.line == second.line) {
+            f(getLineView(first.line, first.position, second.position), false);
+            return;
+        }
+
+        f(getLineView(first.line, first.position), true);
+        for (std::size_t line = first.line + 1; line < second.line; line++) {
+            f(getLineView(line), true);
+        }
+        f(getLineView(second.line, 0, second.position), false);
+    }
+
+    template<typename OutputIt>
+    OutputIt Document::copyText(Pos first, Pos second, OutputIt out) const {
+        forEachLineView(first, second, [&out](const LineView &view, bool lineBreak) {
+            out = std::copy(view.begin(), view.end(), out);
+            if (lineBreak) *out++ = '\n';
+        });
+        return out;
+    }
+
+    template<typename OutputIt>
+    OutputIt Document::copyTextUtf8(Pos first, Pos second, OutputIt out) const {
+        forEachLineView(first, second, [&out](const LineView &view, bool lineBreak) {
+            out = utf8::encode(view.begin(), view.end(), out);
+            if (lineBreak) *out++ = '\n';
+        });
+        return out;
+    }
+}
+
+#endif //SFML_TEXTBOX_DOCUMENT_HPP
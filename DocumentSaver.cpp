@@ -0,0 +1,48 @@
+#include "DocumentSaver.hpp"
+
+namespace sftb {
+    DocumentSaver::DocumentSaver(DocumentSnapshot snapshot, const std::string &path, LineEnding lineEnding) :
+            numberLines(snapshot.getNumberLines()), snapshot(std::move(snapshot)),
+            file(path, std::ios::binary | std::ios::trunc), out(&file), lineEnding(lineEnding) {
+        start();
+    }
+
+    DocumentSaver::DocumentSaver(DocumentSnapshot snapshot, std::ostream &out, LineEnding lineEnding) :
+            numberLines(snapshot.getNumberLines()), snapshot(std::move(snapshot)), out(&out), lineEnding(lineEnding) {
+        start();
+    }
+
+    DocumentSaver::~DocumentSaver() {
+        wait();
+    }
+
+    void DocumentSaver::start() {
+        if (!*out) {
+            status.store(Status::Failed, std::memory_order_release);
+            return;
+        }
+        thread = std::thread([this] {
+            bool written = snapshot.write(*out, lineEnding, &linesWritten, &cancelled);
+            if (file.is_open()) {
+                file.close();
+                if (!file) written = false;
+            }
+            // the snapshot is released before the status is set, a finished saver does not keep its lines alive
+            snapshot = DocumentSnapshot();
+            Status result = written ? Status::Finished :
+                            cancelled.load(std::memory_order_relaxed) ? Status::Cancelled : Status::Failed;
+            status.store(result, std::memory_order_release);
+        });
+    }
+
+    void DocumentSaver::wait() {
+        if (thread.joinable()) thread.join();
+    }
+
+    float DocumentSaver::getProgress() const {
+        if (getStatus() == Status::Finished) return 1;
+        if (numberLines == 0) return 0;
+        return static_cast<float>(static_cast<double>(linesWritten.load(std::memory_order_relaxed)) /
+                                  static_cast<double>(numberLines));
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef SFML_TEXTBOX_DOCUMENTSAVER_HPP
+#define SFML_TEXTBOX_DOCUMENTSAVER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include "DocumentSnapshot.hpp"
+
+namespace sftb {
+    /**
+     * Writes a DocumentSnapshot as UTF-8 on a background thread, see TextBox::saveFile(). The document may be edited
+     * while it is saved, the saved text is the text at the time of the snapshot. The text is encoded and written a
+     * buffer at a time, so saving does not build a copy of the document.
+     */
+    class DocumentSaver {
+    public:
+        enum class Status {
+            Saving, Finished, Cancelled, Failed
+        };
+    private:
+        const std::size_t numberLines;
+        // released once written
+        DocumentSnapshot snapshot;
+        // the file written, when saving to a path
+        std::ofstream file;
+        std::ostream *out;
+        LineEnding lineEnding;
+        std::atomic<std::size_t> linesWritten{0};
+        std::atomic<Status> status{Status::Saving};
+        std::atomic<bool> cancelled{false};
+        std::thread thread;
+
+        void start();
+    public:
+        // starts writing snapshot to path, replacing its contents
+        DocumentSaver(DocumentSnapshot snapshot, const std::string &path, LineEnding lineEnding = LineEnding::LF);
+        // starts writing snapshot to out, which must outlive the saver and not be used until it is done
+        DocumentSaver(DocumentSnapshot snapshot, std::ostream &out, LineEnding lineEnding = LineEnding::LF);
+        // waits for the saving to end, call cancel() first to stop it early
+        ~DocumentSaver();
+
+        DocumentSaver(const DocumentSaver &) = delete;
+        DocumentSaver &operator=(const DocumentSaver &) = delete;
+
+        // stops writing, what was written so far is kept
+        void cancel() {
+            cancelled.store(true, std::memory_order_relaxed);
+        }
+
+        // blocks until the saving has ended
+        void wait();
+
+        // Finished, Cancelled or Failed once the saving has ended
+        [[nodiscard]] Status getStatus() const {
+            return status.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] bool isDone() const {
+            return getStatus() != Status::Saving;
+        }
+
+        // fraction of the lines which have been written, 1 once the saving has finished
+        [[nodiscard]] float getProgress() const;
+    };
+}
+
+#endif //SFML_TEXTBOX_DOCUMENTSAVER_HPP
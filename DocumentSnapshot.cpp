@@ -0,0 +1,47 @@
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include "DocumentSnapshot.hpp"
+
+namespace sftb {
+    LineView DocumentSnapshot::getLineView(std::size_t line) const {
+        assert(line < getNumberLines() && "line out of bounds");
+        const std::vector<std::size_t> &starts = data->chunkStarts;
+        auto chunk = static_cast<std::size_t>(std::upper_bound(starts.begin(), starts.end(), line) - starts.begin() - 1);
+        const std::shared_ptr<const detail::LineText> &text = data->chunks[chunk]->lines[line - starts[chunk]];
+        return text ? LineView(text->data(), text->size()) : LineView();
+    }
+
+    bool DocumentSnapshot::write(std::ostream &out, LineEnding lineEnding, std::atomic<std::size_t> *linesWritten,
+                                 const std::atomic<bool> *cancel) const {
+        // lines are encoded into a buffer of about BUFFER_SIZE bytes, which is written once full
+        constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+        const char *lineBreak = lineEnding == LineEnding::CRLF ? "\r\n" : lineEnding == LineEnding::CR ? "\r" : "\n";
+
+        std::string buffer;
+        buffer.reserve(BUFFER_SIZE + 64);
+        std::size_t line = 0;
+        for (std::size_t chunk = 0; data && chunk < data->chunks.size(); chunk++) {
+            for (const auto &text : data->chunks[chunk]->lines) {
+                if (line++ != 0) buffer += lineBreak;
+                if (!text) continue;
+                // long lines are encoded in slices, so the buffer stays about BUFFER_SIZE bytes
+                for (const Char *slice = text->data(), *end = slice + text->size(); slice != end;) {
+                    const Char *sliceEnd = slice + std::min<std::size_t>(end - slice, BUFFER_SIZE / 4);
+                    utf8::encode(slice, sliceEnd, std::back_inserter(buffer));
+                    slice = sliceEnd;
+                    if (buffer.size() < BUFFER_SIZE) continue;
+
+                    if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+                    if (!out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()))) return false;
+                    buffer.clear();
+                    if (linesWritten) linesWritten->store(line - 1, std::memory_order_relaxed);
+                }
+            }
+        }
+        if (cancel && cancel->load(std::memory_order_relaxed)) return false;
+        if (!out.write(buffer.data(), static_cast<std::streamsize>(buffer.size())) || !out.flush()) return false;
+        if (linesWritten) linesWritten->store(line, std::memory_order_relaxed);
+        return true;
+    }
+}
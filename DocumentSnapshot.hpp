@@ -0,0 +1,82 @@
+#ifndef SFML_TEXTBOX_DOCUMENTSNAPSHOT_HPP
+#define SFML_TEXTBOX_DOCUMENTSNAPSHOT_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "Document.hpp"
+
+namespace sftb {
+    // line break written between lines when a document is saved
+    enum class LineEnding {
+        LF, CRLF, CR
+    };
+
+    namespace detail {
+        // consecutive lines of a snapshot, shared by the following snapshots until one of the lines changes
+        struct SnapshotChunk {
+            // nullptr for empty lines
+            std::vector<std::shared_ptr<const LineText>> lines;
+        };
+
+        struct SnapshotData {
+            std::vector<std::shared_ptr<const SnapshotChunk>> chunks;
+            // first line of each chunk
+            std::vector<std::size_t> chunkStarts;
+            std::size_t numberLines = 0;
+            std::size_t numberCharacters = 0;
+        };
+    }
+
+    /**
+     * Immutable text of a Document at the time of Document::getSnapshot(). A snapshot shares its lines with the
+     * document, which copies a line before modifying it, and with the previous snapshot (if still held) in chunks of
+     * lines, so taking a snapshot costs in proportion to what changed since the previous one rather than a copy of
+     * the text.
+     * Snapshots are cheap to copy, and may be read by any number of threads without locking while the document is
+     * edited.
+     */
+    class DocumentSnapshot {
+        friend class Document;
+    private:
+        std::shared_ptr<const detail::SnapshotData> data;
+
+        explicit DocumentSnapshot(std::shared_ptr<const detail::SnapshotData> data) : data(std::move(data)) {}
+    public:
+        // a document with no lines
+        DocumentSnapshot() = default;
+
+        [[nodiscard]] std::size_t getNumberLines() const {
+            return data ? data->numberLines : 0;
+        }
+
+        // not including line breaks
+        [[nodiscard]] std::size_t getNumberCharacters() const {
+            return data ? data->numberCharacters : 0;
+        }
+
+        // O(log(number of lines))
+        [[nodiscard]] LineView getLineView(std::size_t line) const;
+
+        // calls f(view) for each line, in order
+        template<typename F>
+        void forEachLineView(F f) const {
+            if (!data) return;
+            for (const auto &chunk : data->chunks) {
+                for (const auto &text : chunk->lines) {
+                    f(text ? LineView(text->data(), text->size()) : LineView());
+                }
+            }
+        }
+
+        // writes the lines to out as UTF-8, separated by lineEnding, a buffer at a time. linesWritten, if given, is
+        // updated after each buffer, and writing stops once cancel (if given) is set
+        // returns false if writing failed or was cancelled
+        bool write(std::ostream &out, LineEnding lineEnding = LineEnding::LF,
+                   std::atomic<std::size_t> *linesWritten = nullptr, const std::atomic<bool> *cancel = nullptr) const;
+    };
+}
+
+#endif //SFML_TEXTBOX_DOCUMENTSNAPSHOT_HPP
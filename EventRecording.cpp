@@ -0,0 +1,203 @@
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/System/Sleep.hpp>
+#include <algorithm>
+#include <cstring>
+#include "EventRecording.hpp"
+#include "TextBox.hpp"
+
+namespace sftb {
+    namespace {
+        constexpr char HEADER[8] = {'S', 'F', 'T', 'B', 'E', 'V', 'T', 1};
+
+        void writeUnsigned(std::ostream &out, std::uint64_t value) {
+            do {
+                auto byte = static_cast<unsigned char>(value & 0x7F);
+                value >>= 7;
+                if (value != 0) byte |= 0x80;
+                out.put(static_cast<char>(byte));
+            } while (value != 0);
+        }
+
+        void writeSigned(std::ostream &out, std::int64_t value) {
+            writeUnsigned(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+        }
+
+        void writeFloat(std::ostream &out, float value) {
+            std::uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            for (int i = 0; i < 4; i++) out.put(static_cast<char>((bits >> (8 * i)) & 0xFF));
+        }
+
+        // the read functions set valid to false if the stream ends early
+        std::uint64_t readUnsigned(std::istream &in, bool &valid) {
+            std::uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7) {
+                int byte = in.get();
+                if (byte == std::istream::traits_type::eof()) break;
+                value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) return value;
+            }
+            valid = false;
+            return 0;
+        }
+
+        std::int64_t readSigned(std::istream &in, bool &valid) {
+            std::uint64_t value = readUnsigned(in, valid);
+            return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+        }
+
+        float readFloat(std::istream &in, bool &valid) {
+            std::uint32_t bits = 0;
+            for (int i = 0; i < 4; i++) {
+                int byte = in.get();
+                if (byte == std::istream::traits_type::eof()) valid = false;
+                bits |= static_cast<std::uint32_t>(byte & 0xFF) << (8 * i);
+            }
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        bool isRecorded(sf::Event::EventType type) {
+            switch (type) {
+                case sf::Event::KeyPressed:
+                case sf::Event::KeyReleased:
+                case sf::Event::TextEntered:
+                case sf::Event::MouseWheelScrolled:
+                case sf::Event::MouseButtonPressed:
+                case sf::Event::MouseButtonReleased:
+                case sf::Event::MouseMoved:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+    }
+
+    EventRecorder::EventRecorder(std::ostream &out) : out(&out) {
+        out.write(HEADER, sizeof(HEADER));
+    }
+
+    void EventRecorder::record(const sf::Event &event, bool verifyArea) {
+        if (!isRecorded(event.type)) return;
+
+        sf::Time now = clock.getElapsedTime();
+        writeUnsigned(*out, static_cast<std::uint64_t>((now - previous).asMicroseconds()));
+        previous = now;
+        out->put(static_cast<char>(event.type));
+        out->put(static_cast<char>(verifyArea));
+
+        switch (event.type) {
+            case sf::Event::KeyPressed:
+            case sf::Event::KeyReleased:
+                writeSigned(*out, event.key.code);
+                out->put(static_cast<char>(event.key.alt | event.key.control << 1 | event.key.shift << 2 |
+                                           event.key.system << 3));
+                break;
+            case sf::Event::TextEntered:
+                writeUnsigned(*out, event.text.unicode);
+                break;
+            case sf::Event::MouseWheelScrolled:
+                out->put(static_cast<char>(event.mouseWheelScroll.wheel));
+                writeFloat(*out, event.mouseWheelScroll.delta);
+                writeSigned(*out, event.mouseWheelScroll.x);
+                writeSigned(*out, event.mouseWheelScroll.y);
+                break;
+            case sf::Event::MouseButtonPressed:
+            case sf::Event::MouseButtonReleased:
+                out->put(static_cast<char>(event.mouseButton.button));
+                writeSigned(*out, event.mouseButton.x);
+                writeSigned(*out, event.mouseButton.y);
+                break;
+            case sf::Event::MouseMoved:
+                writeSigned(*out, event.mouseMove.x);
+                writeSigned(*out, event.mouseMove.y);
+                break;
+            default:
+                break;
+        }
+    }
+
+    EventReplayer::EventReplayer(std::istream &in) : in(&in) {
+        char header[sizeof(HEADER)];
+        valid = static_cast<bool>(in.read(header, sizeof(header))) &&
+                std::equal(header, header + sizeof(header), HEADER);
+    }
+
+    std::optional<RecordedEvent> EventReplayer::next() {
+        if (!valid || in->peek() == std::istream::traits_type::eof()) return std::nullopt;
+
+        RecordedEvent recorded{};
+        time += sf::microseconds(static_cast<sf::Int64>(readUnsigned(*in, valid)));
+        recorded.time = time;
+        auto type = static_cast<sf::Event::EventType>(in->get());
+        recorded.event.type = type;
+        recorded.verifyArea = in->get() == 1;
+
+        sf::Event &event = recorded.event;
+        switch (type) {
+            case sf::Event::KeyPressed:
+            case sf::Event::KeyReleased: {
+                event.key.code = static_cast<sf::Keyboard::Key>(readSigned(*in, valid));
+                int modifiers = in->get();
+                event.key.alt = modifiers & 1;
+                event.key.control = modifiers & 2;
+                event.key.shift = modifiers & 4;
+                event.key.system = modifiers & 8;
+                break;
+            }
+            case sf::Event::TextEntered:
+                event.text.unicode = static_cast<sf::Uint32>(readUnsigned(*in, valid));
+                break;
+            case sf::Event::MouseWheelScrolled:
+                event.mouseWheelScroll.wheel = static_cast<sf::Mouse::Wheel>(in->get());
+                event.mouseWheelScroll.delta = readFloat(*in, valid);
+                event.mouseWheelScroll.x = static_cast<int>(readSigned(*in, valid));
+                event.mouseWheelScroll.y = static_cast<int>(readSigned(*in, valid));
+                break;
+            case sf::Event::MouseButtonPressed:
+            case sf::Event::MouseButtonReleased:
+                event.mouseButton.button = static_cast<sf::Mouse::Button>(in->get());
+                event.mouseButton.x = static_cast<int>(readSigned(*in, valid));
+                event.mouseButton.y = static_cast<int>(readSigned(*in, valid));
+                break;
+            case sf::Event::MouseMoved:
+                event.mouseMove.x = static_cast<int>(readSigned(*in, valid));
+                event.mouseMove.y = static_cast<int>(readSigned(*in, valid));
+                break;
+            default:
+                valid = false;
+        }
+
+        if (!*in) valid = false;
+        if (!valid) return std::nullopt;
+        return recorded;
+    }
+
+    std::size_t EventReplayer::replay(TextBox &box, sf::RenderTarget *target, bool realTime) {
+        auto frame = [&box, target] {
+            box.update();
+            if (target && box.isRedrawRequired()) {
+                target->clear();
+                target->draw(box);
+            }
+        };
+
+        sf::Clock clock;
+        std::size_t count = 0;
+        while (std::optional<RecordedEvent> recorded = next()) {
+            if (realTime) {
+                // keep drawing frames while waiting for the event
+                while (clock.getElapsedTime() < recorded->time) {
+                    frame();
+                    sf::sleep(std::min(recorded->time - clock.getElapsedTime(), sf::milliseconds(1)));
+                }
+            }
+            frame();
+            box.handleEvent(recorded->event, recorded->verifyArea);
+            count++;
+        }
+        frame();
+        return count;
+    }
+}
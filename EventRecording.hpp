@@ -0,0 +1,72 @@
+#ifndef SFML_TEXTBOX_EVENTRECORDING_HPP
+#define SFML_TEXTBOX_EVENTRECORDING_HPP
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/Window/Event.hpp>
+#include <istream>
+#include <optional>
+#include <ostream>
+
+namespace sf {
+    class RenderTarget;
+}
+
+namespace sftb {
+    class TextBox;
+
+    /**
+     * Writes the events passed to TextBox::handleEvent() to a compact binary stream, with the time each event was
+     * received, see TextBox::setEventRecorder(). Only the event types handled by a TextBox are recorded.
+     *
+     * The stream starts with an 8 byte header, followed by one record per event: the time since the previous event
+     * (in microseconds), the event type, the verifyArea flag and the event's fields. Integers are stored as LEB128
+     * varints (zigzag encoded when signed), floats as 4 little-endian bytes.
+     */
+    class EventRecorder {
+    private:
+        std::ostream *out;
+        sf::Clock clock;
+        sf::Time previous;
+    public:
+        // out must outlive the recorder, the header is written immediately
+        explicit EventRecorder(std::ostream &out);
+
+        void record(const sf::Event &event, bool verifyArea = true);
+    };
+
+    struct RecordedEvent {
+        // since the recording started
+        sf::Time time;
+        sf::Event event;
+        bool verifyArea;
+    };
+
+    /**
+     * Reads a stream written by an EventRecorder, and feeds it into a TextBox without a window.
+     */
+    class EventReplayer {
+    private:
+        std::istream *in;
+        sf::Time time;
+        bool valid;
+    public:
+        // in must outlive the replayer, the header is read immediately
+        explicit EventReplayer(std::istream &in);
+
+        // false if the header was not recognized, or a record could not be read
+        [[nodiscard]] bool isValid() const {
+            return valid;
+        }
+
+        // the next event, or nothing at the end of the stream (or if the stream is invalid)
+        std::optional<RecordedEvent> next();
+
+        // passes each remaining event to box.handleEvent(), calling box.update() and drawing box into target (if not
+        // nullptr) before each event whenever a redraw is required, as a frame loop would. With realTime, each event is
+        // passed once the time it was recorded at has passed since replay() started, otherwise events are passed as
+        // fast as possible. Returns the number of events replayed
+        std::size_t replay(TextBox &box, sf::RenderTarget *target = nullptr, bool realTime = false);
+    };
+}
+
+#endif //SFML_TEXTBOX_EVENTRECORDING_HPP
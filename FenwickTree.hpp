@@ -0,0 +1,133 @@
+#ifndef SFML_TEXTBOX_FENWICKTREE_HPP
+#define SFML_TEXTBOX_FENWICKTREE_HPP
+
+#include <vector>
+#include <cassert>
+
+namespace sftb::detail {
+    /**
+     * Binary indexed tree over a sequence of non-negative values.
+     * Supports O(log n) point updates, prefix sums and prefix sum searches. Elements can be appended or removed at the
+     * end in O(log n), and removed at the start in O(log n) amortized; inserting or removing other elements requires
+     * rebuilding the tree, which is O(n).
+     */
+    template<typename T>
+    class FenwickTree {
+    private:
+        // 1-based, tree[0] is unused
+        std::vector<T> tree = std::vector<T>(1);
+        std::size_t highestStep = 0;
+        // number of elements removed from the start, which are kept in the tree with a value of 0, see popFront()
+        std::size_t front = 0;
+
+        void updateHighestStep() {
+            std::size_t count = tree.size() - 1;
+            highestStep = 1;
+            while (highestStep * 2 <= count) highestStep *= 2;
+            if (count == 0) highestStep = 0;
+        }
+
+        // sum of the first count elements of tree, including removed elements
+        [[nodiscard]] T treePrefixSum(std::size_t count) const {
+            T sum = T();
+            for (std::size_t i = count; i > 0; i -= i & -i) {
+                sum += tree[i];
+            }
+            return sum;
+        }
+    public:
+        FenwickTree() = default;
+
+        // valueAt(i) returns the value of element i, for all 0 <= i < count
+        template<typename F>
+        void build(std::size_t count, F valueAt) {
+            tree.assign(count + 1, T());
+            for (std::size_t i = 1; i <= count; i++) {
+                tree[i] += valueAt(i - 1);
+                std::size_t parent = i + (i & -i);
+                if (parent <= count) tree[parent] += tree[i];
+            }
+
+            front = 0;
+            updateHighestStep();
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return tree.size() - 1 - front;
+        }
+
+        void add(std::size_t index, T delta) {
+            assert(index < size() && "index out of bounds");
+            for (std::size_t i = front + index + 1; i < tree.size(); i += i & -i) {
+                tree[i] += delta;
+            }
+        }
+
+        // sum of the first count elements
+        [[nodiscard]] T prefixSum(std::size_t count) const {
+            assert(count <= size() && "count out of bounds");
+            // removed elements are 0
+            return treePrefixSum(front + count);
+        }
+
+        [[nodiscard]] T get(std::size_t index) const {
+            return prefixSum(index + 1) - prefixSum(index);
+        }
+
+        void pushBack(T value) {
+            // the new node covers itself and the elements before it up to its lowest set bit
+            std::size_t i = tree.size();
+            tree.push_back(treePrefixSum(i - 1) - treePrefixSum(i - (i & -i)) + value);
+            updateHighestStep();
+        }
+
+        // removes the elements after the first count elements, nodes only cover elements before them
+        void truncate(std::size_t count) {
+            assert(count <= size() && "count out of bounds");
+            tree.resize(front + count + 1);
+            updateHighestStep();
+        }
+
+        void popFront(std::size_t count) {
+            assert(count <= size() && "count out of bounds");
+            for (std::size_t index = 0; index < count; index++) {
+                // unsigned arithmetic, wraps around to subtract
+                add(index, T() - get(index));
+            }
+            front += count;
+            if (front < size()) return;
+
+            // the removed elements are at least half the tree, rebuild it without them
+            // convert the nodes back to elements, in the reverse order of build()
+            std::size_t total = tree.size() - 1;
+            for (std::size_t i = total; i > 0; i--) {
+                std::size_t parent = i + (i & -i);
+                if (parent <= total) tree[parent] -= tree[i];
+            }
+            std::vector<T> values(tree.begin() + static_cast<std::ptrdiff_t>(front) + 1, tree.end());
+            build(values.size(), [&values](std::size_t index) {
+                return values[index];
+            });
+        }
+
+        [[nodiscard]] T total() const {
+            return prefixSum(size());
+        }
+
+        // largest count such that prefixSum(count) <= target
+        // for positive values, this is the index of the element containing target
+        [[nodiscard]] std::size_t search(T target) const {
+            std::size_t position = 0;
+            for (std::size_t step = highestStep; step > 0; step /= 2) {
+                if (position + step < tree.size() && tree[position + step] <= target) {
+                    position += step;
+                    target -= tree[position];
+                }
+            }
+            // the removed elements are 0, so position includes all of them
+            return position - front;
+        }
+    };
+}
+
+#endif //SFML_TEXTBOX_FENWICKTREE_HPP
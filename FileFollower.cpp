@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include "FileFollower.hpp"
+#include "Utf8.hpp"
+
+#ifdef __linux__
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sftb {
+    FileFollower::FileFollower(std::string path, bool skipExisting) : path(std::move(path)) {
+#ifdef __linux__
+        stopFd = eventfd(0, EFD_CLOEXEC);
+        if (stopFd >= 0) {
+            thread = std::thread([this, skipExisting] {
+                run(skipExisting);
+            });
+            return;
+        }
+#else
+        (void) skipExisting;
+#endif
+        status.store(Status::Failed, std::memory_order_release);
+    }
+
+    FileFollower::~FileFollower() {
+#ifdef __linux__
+        if (thread.joinable()) {
+            std::uint64_t stop = 1;
+            // the thread is waiting on stopFd, which cannot fail to be written once
+            (void) !write(stopFd, &stop, sizeof(stop));
+            thread.join();
+        }
+        if (stopFd >= 0) close(stopFd);
+#endif
+    }
+
+    void FileFollower::publish(std::basic_string<sf::Uint32> &text) {
+        // "\r\n" is read as '\n', a '\r' at the end is kept until the next read shows whether '\n' follows it
+        bool carriageReturn = !text.empty() && text.back() == '\r';
+        if (carriageReturn) text.pop_back();
+        auto out = text.begin();
+        for (auto iter = text.begin(); iter != text.end(); iter++) {
+            if (*iter != '\r' || iter + 1 == text.end() || iter[1] != '\n') *out++ = *iter;
+        }
+        text.erase(out, text.end());
+
+        if (!text.empty()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (chunks.empty() || chunks.back().size() >= BLOCK_SIZE) chunks.push_back(text);
+            else chunks.back() += text;
+        }
+        text.clear();
+        if (carriageReturn) text.push_back('\r');
+    }
+
+    void FileFollower::publishReset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        reset = true;
+        chunks.clear();
+        bytesRead.store(0, std::memory_order_relaxed);
+    }
+
+    FileFollower::Update FileFollower::takeUpdate() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Update update{reset, {}};
+        reset = false;
+        if (!chunks.empty()) {
+            update.text = chunks.front();
+            chunks.pop_front();
+        }
+        return update;
+    }
+
+#ifdef __linux__
+    void FileFollower::run(bool skipExisting) {
+        // the directory is watched for a file created with the name of the followed file, which replaces it
+        std::size_t slash = path.find_last_of('/');
+        std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+
+        int inotifyFd = inotify_init1(IN_CLOEXEC);
+        int directoryWatch = inotifyFd < 0 ? -1 : inotify_add_watch(inotifyFd, directory.c_str(),
+                                                                     IN_CREATE | IN_MOVED_TO);
+        if (directoryWatch < 0) {
+            if (inotifyFd >= 0) close(inotifyFd);
+            status.store(Status::Failed, std::memory_order_release);
+            return;
+        }
+
+        int fd = -1, fileWatch = -1;
+        // bytes of a sequence left incomplete by the last read, followed by the bytes read
+        std::vector<char> bytes;
+        // decoded text of the current block, published once the block is read
+        std::basic_string<sf::Uint32> text;
+
+        auto openFile = [&](bool atEnd) {
+            fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return;
+            fileWatch = inotify_add_watch(inotifyFd, path.c_str(), IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF);
+            if (atEnd) lseek(fd, 0, SEEK_END);
+        };
+        auto closeFile = [&] {
+            if (fd < 0) return;
+            // fails harmlessly if the watch was already removed with a deleted file
+            inotify_rm_watch(inotifyFd, fileWatch);
+            close(fd);
+            fd = fileWatch = -1;
+            bytes.clear();
+            text.clear();
+        };
+        // reads the bytes appended since the last read, from the start if the file was truncated since
+        auto readAppended = [&] {
+            if (fd < 0) return;
+            struct stat info{};
+            if (fstat(fd, &info) == 0 && info.st_size < lseek(fd, 0, SEEK_CUR)) {
+                lseek(fd, 0, SEEK_SET);
+                bytes.clear();
+                text.clear();
+                publishReset();
+            }
+            while (true) {
+                std::size_t kept = bytes.size();
+                bytes.resize(kept + BLOCK_SIZE);
+                ssize_t count = read(fd, bytes.data() + kept, BLOCK_SIZE);
+                bytes.resize(kept + static_cast<std::size_t>(std::max<ssize_t>(count, 0)));
+                if (count <= 0) break;
+                bytesRead.fetch_add(static_cast<std::uintmax_t>(count), std::memory_order_relaxed);
+
+                auto [decoded, out] = utf8::decode(bytes.data(), bytes.data() + bytes.size(), std::back_inserter(text));
+                bytes.erase(bytes.begin(), bytes.begin() + (decoded - bytes.data()));
+                publish(text);
+            }
+        };
+
+        openFile(skipExisting);
+        readAppended();
+
+        pollfd fds[] = {{inotifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+        alignas(inotify_event) char events[4096];
+        while (true) {
+            if (poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                status.store(Status::Failed, std::memory_order_release);
+                break;
+            }
+            if (fds[1].revents != 0) {
+                status.store(Status::Stopped, std::memory_order_release);
+                break;
+            }
+
+            // every event queued is handled by a single read of the file
+            bool replaced = false, created = false;
+            ssize_t length = read(inotifyFd, events, sizeof(events));
+            for (ssize_t i = 0; i < length;) {
+                const auto *event = reinterpret_cast<const inotify_event *>(events + i);
+                if (event->wd == fileWatch && (event->mask & (IN_MOVE_SELF | IN_DELETE_SELF))) replaced = true;
+                if (event->wd == directoryWatch && event->len > 0 && name == event->name) created = true;
+                i += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+
+            if (created && fd >= 0 && !replaced) {
+                // the created file replaces the followed one, unless it is the same file (moved back)
+                struct stat current{}, followed{};
+                replaced = stat(path.c_str(), &current) == 0 && fstat(fd, &followed) == 0 &&
+                           (current.st_ino != followed.st_ino || current.st_dev != followed.st_dev);
+            }
+            if (replaced || (created && fd < 0)) {
+                // the text of a replaced file is discarded by the reset, so the end of it is not read
+                if (fd >= 0) {
+                    closeFile();
+                    publishReset();
+                }
+                openFile(false);
+            }
+            readAppended();
+        }
+
+        closeFile();
+        close(inotifyFd);
+    }
+#else
+    void FileFollower::run(bool) {}
+#endif
+}
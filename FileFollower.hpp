@@ -0,0 +1,81 @@
+#ifndef SFML_TEXTBOX_FILEFOLLOWER_HPP
+#define SFML_TEXTBOX_FILEFOLLOWER_HPP
+
+#include <SFML/System/String.hpp>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace sftb {
+    /**
+     * Follows a file which is being appended to, such as a log, see TextBox::followFile(). A background thread waits
+     * for changes with inotify, reads only the bytes appended since the last read and decodes them (as FileLoader
+     * does) a block at a time; TextBox::update() appends the text read a chunk at a time, within its load time budget.
+     * A file which is truncated, or replaced by another file of the same name (log rotation), is read again from its
+     * start, and the text read before is discarded (see Update::reset).
+     * Only supported on Linux, elsewhere the follower fails immediately.
+     */
+    class FileFollower {
+    public:
+        enum class Status {
+            Following, Stopped, Failed
+        };
+
+        // a change to the file since the previous takeUpdate()
+        struct Update {
+            // the file was truncated or replaced, the text read before should be discarded
+            bool reset = false;
+            // the oldest chunk read after the reset, if any
+            sf::String text;
+        };
+    private:
+        // bytes read at a time, each block read is published as it is decoded
+        static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+        const std::string path;
+        mutable std::mutex mutex;
+        // guarded by mutex
+        bool reset = false;
+        // small reads are added to the last chunk, up to BLOCK_SIZE characters
+        std::deque<std::basic_string<sf::Uint32>> chunks;
+        std::atomic<std::uintmax_t> bytesRead{0};
+        std::atomic<Status> status{Status::Following};
+        // written to stop the thread, -1 if it could not be created
+        int stopFd = -1;
+        std::thread thread;
+
+        void run(bool skipExisting);
+        void publish(std::basic_string<sf::Uint32> &text);
+        void publishReset();
+    public:
+        // starts following path, which does not need to exist yet. With skipExisting, the text already in the file is
+        // not read
+        explicit FileFollower(std::string path, bool skipExisting = false);
+        // stops following
+        ~FileFollower();
+
+        FileFollower(const FileFollower &) = delete;
+        FileFollower &operator=(const FileFollower &) = delete;
+
+        [[nodiscard]] const std::string &getPath() const {
+            return path;
+        }
+
+        [[nodiscard]] Status getStatus() const {
+            return status.load(std::memory_order_acquire);
+        }
+
+        // bytes read from the file since the last reset
+        [[nodiscard]] std::uintmax_t getBytesRead() const {
+            return bytesRead.load(std::memory_order_relaxed);
+        }
+
+        // the reset and the oldest chunk of text not taken yet, an empty update if the file did not change
+        Update takeUpdate();
+    };
+}
+
+#endif //SFML_TEXTBOX_FILEFOLLOWER_HPP
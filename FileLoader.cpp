@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "FileLoader.hpp"
+#include "Utf8.hpp"
+
+namespace sftb {
+    FileLoader::FileLoader(const std::string &path) {
+        thread = std::thread([this, path] {
+            read(path);
+        });
+    }
+
+    FileLoader::~FileLoader() {
+        cancel();
+        if (thread.joinable()) thread.join();
+    }
+
+    void FileLoader::read(const std::string &path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file) {
+            status.store(Status::Failed, std::memory_order_release);
+            return;
+        }
+        fileSize.store(static_cast<std::uintmax_t>(file.tellg()), std::memory_order_relaxed);
+        file.seekg(0);
+
+        // bytes of a sequence left incomplete at the end of the previous block, followed by the current block
+        std::vector<char> bytes;
+        // decoded text after the last line break
+        std::basic_string<sf::Uint32> text;
+        std::size_t blockSize = MIN_BLOCK_SIZE;
+        while (!cancelled.load(std::memory_order_relaxed)) {
+            std::size_t kept = bytes.size();
+            bytes.resize(kept + blockSize);
+            file.read(bytes.data() + kept, static_cast<std::streamsize>(blockSize));
+            auto count = static_cast<std::size_t>(file.gcount());
+            bytes.resize(kept + count);
+            if (count == 0) break;
+            bytesRead.fetch_add(count, std::memory_order_relaxed);
+
+            // text has no line break before the newly decoded part
+            std::size_t scanned = text.size();
+            auto [decoded, out] = utf8::decode(bytes.data(), bytes.data() + bytes.size(), std::back_inserter(text));
+            bytes.erase(bytes.begin(), bytes.begin() + (decoded - bytes.data()));
+
+            // the chunk ends with the last complete line, the rest of the text starts the next chunk
+            auto newText = text.rend() - static_cast<std::ptrdiff_t>(scanned);
+            auto lineBreak = std::find(text.rbegin(), newText, '\n');
+            auto lineEnd = lineBreak == newText ? text.begin() : lineBreak.base();
+            if (lineEnd == text.begin() && text.size() >= MAX_BLOCK_SIZE) {
+                // a long line is published in parts, appended to the last line of the document. A '\r' is kept with
+                // the next part, in case it is followed by '\n'
+                lineEnd = text.back() == '\r' ? text.end() - 1 : text.end();
+            }
+            if (lineEnd != text.begin()) {
+                addChunk(text.substr(0, lineEnd - text.begin()));
+                text.erase(text.begin(), lineEnd);
+            }
+            blockSize = std::min(blockSize * 2, MAX_BLOCK_SIZE);
+        }
+
+        if (cancelled.load(std::memory_order_relaxed)) {
+            status.store(Status::Cancelled, std::memory_order_release);
+            return;
+        }
+        if (file.bad()) {
+            status.store(Status::Failed, std::memory_order_release);
+            return;
+        }
+        // the file ends within a sequence
+        if (!bytes.empty()) text.push_back(utf8::REPLACEMENT_CHARACTER);
+        if (!text.empty()) addChunk(std::move(text));
+        status.store(Status::Finished, std::memory_order_release);
+    }
+
+    void FileLoader::addChunk(std::basic_string<sf::Uint32> text) {
+        // "\r\n" is read as '\n', a chunk never ends between them (see read())
+        auto out = text.begin();
+        for (auto iter = text.begin(); iter != text.end(); iter++) {
+            if (*iter != '\r' || iter + 1 == text.end() || iter[1] != '\n') *out++ = *iter;
+        }
+        text.erase(out, text.end());
+        sf::String chunk(text);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks.push_back(std::move(chunk));
+    }
+
+    float FileLoader::getProgress() const {
+        if (getStatus() == Status::Finished) return 1;
+        std::uintmax_t size = fileSize.load(std::memory_order_relaxed);
+        if (size == 0) return 0;
+        return static_cast<float>(static_cast<double>(bytesRead.load(std::memory_order_relaxed)) /
+                                  static_cast<double>(size));
+    }
+
+    std::optional<sf::String> FileLoader::takeChunk() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (chunks.empty()) return std::nullopt;
+        sf::String chunk = std::move(chunks.front());
+        chunks.pop_front();
+        return chunk;
+    }
+
+    bool FileLoader::isDone() const {
+        // the status is checked first, so no chunk can be added after chunks is found to be empty
+        if (getStatus() == Status::Loading) return false;
+        std::lock_guard<std::mutex> lock(mutex);
+        return chunks.empty();
+    }
+}
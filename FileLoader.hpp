@@ -0,0 +1,73 @@
+#ifndef SFML_TEXTBOX_FILELOADER_HPP
+#define SFML_TEXTBOX_FILELOADER_HPP
+
+#include <SFML/System/String.hpp>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace sftb {
+    /**
+     * Reads and decodes a UTF-8 file on a background thread into chunks of whole lines, which TextBox::update()
+     * appends to the document a few at a time (see TextBox::loadFile()). The start of the file is shown, scrolled
+     * and searched while the rest of it is read. A line longer than MAX_BLOCK_SIZE characters is split over several
+     * chunks, each appended to the end of the previous one.
+     * Line breaks ("\r\n" or "\n") are read as '\n', invalid UTF-8 is read as U+FFFD.
+     */
+    class FileLoader {
+    public:
+        enum class Status {
+            Loading, Finished, Cancelled, Failed
+        };
+    private:
+        // chunks are read in blocks starting at MIN_BLOCK_SIZE bytes (so the first screen is available quickly),
+        // doubling up to MAX_BLOCK_SIZE bytes
+        static constexpr std::size_t MIN_BLOCK_SIZE = 16 * 1024;
+        static constexpr std::size_t MAX_BLOCK_SIZE = 256 * 1024;
+
+        mutable std::mutex mutex;
+        // guarded by mutex
+        std::deque<sf::String> chunks;
+        std::atomic<std::uintmax_t> bytesRead{0};
+        std::atomic<std::uintmax_t> fileSize{0};
+        std::atomic<Status> status{Status::Loading};
+        std::atomic<bool> cancelled{false};
+        std::thread thread;
+
+        void read(const std::string &path);
+        void addChunk(std::basic_string<sf::Uint32> text);
+    public:
+        // starts reading path
+        explicit FileLoader(const std::string &path);
+        // cancels the loading, if still in progress
+        ~FileLoader();
+
+        FileLoader(const FileLoader &) = delete;
+        FileLoader &operator=(const FileLoader &) = delete;
+
+        // stops reading, the chunks read so far are still available
+        void cancel() {
+            cancelled.store(true, std::memory_order_relaxed);
+        }
+
+        // Finished, Cancelled or Failed once the file has been read (or could not be), chunks may remain to be taken
+        [[nodiscard]] Status getStatus() const {
+            return status.load(std::memory_order_acquire);
+        }
+
+        // fraction of the file which has been read, 1 once it is read
+        [[nodiscard]] float getProgress() const;
+
+        // the oldest chunk which has not been taken yet, in the order of the file
+        std::optional<sf::String> takeChunk();
+
+        // true once every chunk of the file has been taken
+        [[nodiscard]] bool isDone() const;
+    };
+}
+
+#endif //SFML_TEXTBOX_FILELOADER_HPP
@@ -0,0 +1,91 @@
+#include <SFML/Graphics/Font.hpp>
+#include <iterator>
+#include <map>
+#include <tuple>
+#include <limits>
+#include "GlyphMetrics.hpp"
+
+namespace sftb {
+    namespace {
+        using MetricsKey = std::tuple<const sf::Font *, unsigned, bool>;
+
+        // character sizes and styles of a font kept cached while unused, beyond them the unused ones are removed
+        constexpr std::size_t MAX_CACHED_METRICS = 16;
+
+        std::map<MetricsKey, std::shared_ptr<const GlyphMetrics>> &getMetricsCache() {
+            static std::map<MetricsKey, std::shared_ptr<const GlyphMetrics>> cache;
+            return cache;
+        }
+
+        // see GlyphMetrics::use()
+        std::map<const sf::Font *, std::weak_ptr<const void>> &getFontUses() {
+            static std::map<const sf::Font *, std::weak_ptr<const void>> uses;
+            return uses;
+        }
+    }
+
+    GlyphMetrics::GlyphMetrics(const sf::Font &font, unsigned characterSize, bool bold) :
+            font(&font), characterSize(characterSize), bold(bold), lineSpacing(font.getLineSpacing(characterSize)) {
+    }
+
+    std::shared_ptr<const GlyphMetrics> GlyphMetrics::get(const sf::Font &font, unsigned characterSize, bool bold) {
+        auto &cache = getMetricsCache();
+        MetricsKey key{&font, characterSize, bold};
+        auto iter = cache.find(key);
+        if (iter != cache.end()) return iter->second;
+        std::shared_ptr<const GlyphMetrics> metrics = std::make_shared<GlyphMetrics>(font, characterSize, bold);
+
+        // keys are ordered by font first, all entries for font are consecutive. Metrics only referred to by the cache
+        // are removed once there are too many, so changing the character size does not grow the cache without bound
+        auto first = cache.lower_bound({&font, 0, false});
+        auto last = cache.upper_bound({&font, std::numeric_limits<unsigned>::max(), true});
+        if (static_cast<std::size_t>(std::distance(first, last)) >= MAX_CACHED_METRICS) {
+            while (first != last) {
+                if (first->second.use_count() == 1) first = cache.erase(first);
+                else ++first;
+            }
+        }
+        cache.emplace(key, metrics);
+        return metrics;
+    }
+
+    void GlyphMetrics::release(const sf::Font &font) {
+        auto &cache = getMetricsCache();
+        cache.erase(cache.lower_bound({&font, 0, false}),
+                    cache.upper_bound({&font, std::numeric_limits<unsigned>::max(), true}));
+    }
+
+    std::shared_ptr<const void> GlyphMetrics::use(const sf::Font &font) {
+        std::weak_ptr<const void> &use = getFontUses()[&font];
+        std::shared_ptr<const void> shared = use.lock();
+        if (shared) return shared;
+
+        // released once the last holder is destroyed
+        const sf::Font *released = &font;
+        shared = std::shared_ptr<const void>(released, [](const sf::Font *usedFont) {
+            getFontUses().erase(usedFont);
+            release(*usedFont);
+        });
+        use = shared;
+        return shared;
+    }
+
+    float GlyphMetrics::loadAdvance(sf::Uint32 c) const {
+        std::size_t page = c / PAGE_SIZE;
+        if (page >= pages.size()) pages.resize(page + 1);
+        if (!pages[page]) {
+            pages[page] = std::make_unique<Page>();
+            pages[page]->fill(std::numeric_limits<float>::quiet_NaN());
+        }
+
+        float advance = font->getGlyph(c, characterSize, bold).advance;
+        (*pages[page])[c % PAGE_SIZE] = advance;
+        return advance;
+    }
+
+    float GlyphMetrics::loadKerning(sf::Uint64 key, sf::Uint32 first, sf::Uint32 second) const {
+        float amount = font->getKerning(first, second, characterSize);
+        kerning.emplace(key, amount);
+        return amount;
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef SFML_TEXTBOX_GLYPHMETRICS_HPP
+#define SFML_TEXTBOX_GLYPHMETRICS_HPP
+
+#include <SFML/Config.hpp>
+#include <unordered_map>
+#include <vector>
+#include <array>
+#include <memory>
+#include <cmath>
+
+namespace sf {
+    class Font;
+}
+
+namespace sftb {
+    /**
+     * Cached glyph metrics for a single font, character size and style.
+     * Metrics are shared by every TextBox using the same font and character size, and are filled in lazily
+     * as characters are laid out. Advances are stored in dense pages indexed by code point, so looking up
+     * a cached advance does not touch the font.
+     */
+    class GlyphMetrics {
+    public:
+        static constexpr std::size_t PAGE_SIZE = 256;
+    private:
+        using Page = std::array<float, PAGE_SIZE>;
+
+        const sf::Font *font;
+        unsigned characterSize;
+        bool bold;
+        float lineSpacing;
+        // indexed by code point / PAGE_SIZE, nullptr if no character from that page has been used yet
+        // unused entries within a page are NaN
+        mutable std::vector<std::unique_ptr<Page>> pages;
+        // keyed by (first << 32) | second
+        mutable std::unordered_map<sf::Uint64, float> kerning;
+
+        float loadAdvance(sf::Uint32 c) const;
+        float loadKerning(sf::Uint64 key, sf::Uint32 first, sf::Uint32 second) const;
+    public:
+        GlyphMetrics(const sf::Font &font, unsigned characterSize, bool bold);
+
+        GlyphMetrics(const GlyphMetrics &) = delete;
+        GlyphMetrics &operator=(const GlyphMetrics &) = delete;
+
+        /**
+         * Returns the shared metrics for font at characterSize, creating them if they do not exist yet.
+         * The returned metrics remain cached (so switching between character sizes is cheap) until release() is
+         * called for the font, or the font's last use() ends. Of the metrics of a font no longer referred to outside
+         * the cache, only a few are kept.
+         */
+        static std::shared_ptr<const GlyphMetrics> get(const sf::Font &font, unsigned characterSize, bool bold = false);
+
+        /**
+         * Removes all cached metrics for font. The cache is keyed by the font's address, so callers of get() must call
+         * release() before destroying a font they passed in, unless it is still held by use(). Otherwise a font later
+         * allocated at the same address would get stale metrics.
+         */
+        static void release(const sf::Font &font);
+
+        /**
+         * Marks font as used until the returned handle (shared by every user of font) is destroyed, the font is then
+         * released. Each TextBox holds a handle for its font, so its metrics are released with its last TextBox.
+         */
+        static std::shared_ptr<const void> use(const sf::Font &font);
+
+        [[nodiscard]] const sf::Font &getFont() const {
+            return *font;
+        }
+
+        [[nodiscard]] unsigned getCharacterSize() const {
+            return characterSize;
+        }
+
+        [[nodiscard]] bool isBold() const {
+            return bold;
+        }
+
+        [[nodiscard]] float getLineSpacing() const {
+            return lineSpacing;
+        }
+
+        [[nodiscard]] float getAdvance(sf::Uint32 c) const {
+            std::size_t page = c / PAGE_SIZE;
+            if (page < pages.size() && pages[page]) {
+                float advance = (*pages[page])[c % PAGE_SIZE];
+                if (!std::isnan(advance)) return advance;
+            }
+            return loadAdvance(c);
+        }
+
+        [[nodiscard]] float getKerning(sf::Uint32 first, sf::Uint32 second) const {
+            if (first == 0 || second == 0) return 0;
+            sf::Uint64 key = (static_cast<sf::Uint64>(first) << 32u) | second;
+            auto iter = kerning.find(key);
+            return iter == kerning.end() ? loadKerning(key, first, second) : iter->second;
+        }
+    };
+}
+
+#endif //SFML_TEXTBOX_GLYPHMETRICS_HPP
@@ -16,35 +16,40 @@ namespace sftb {
     void sftb::ColorHighlighter::highlight(sf::RenderTarget &target, sf::RenderStates states, const TextBox &box, const Pos &first, const Pos &second) {
         if (!isRangeVisible(box, first, second)) return;
 
+        // with word wrap, a line may span several rows on screen -- work with offsets rather than lines
         sf::Vector2f offsetFirst = box.getOffsetOf(first);
+        sf::Vector2f offsetSecond = box.getOffsetOf(second);
+        float lineStart = box.getTextOffsetHorizontal();
 
         sf::RectangleShape shape;
         shape.setPosition(offsetFirst);
         shape.setFillColor(highlightColor);
 
-        if (first.line == second.line) {
-            shape.setSize({(box.getOffsetOf(second) - offsetFirst).x, box.getLineHeight()});
+        if (offsetFirst.y == offsetSecond.y) {
+            shape.setSize({offsetSecond.x - offsetFirst.x, box.getLineHeight()});
             target.draw(shape, states);
+            detail::countDrawCall();
             return;
         }
 
-        shape.setSize({(box.getSize() - offsetFirst).x, box.getLineHeight()});
+        shape.setSize({box.getSize().x - offsetFirst.x, box.getLineHeight()});
         target.draw(shape, states);
+        detail::countDrawCall();
 
-        if (second.line - 1 > first.line) {
-            std::size_t nextLine = first.line + 1;
-            offsetFirst = box.getOffsetOf({nextLine, 0});
-            shape.setPosition(offsetFirst);
-            shape.setSize({(box.getSize() - offsetFirst).x, box.getLineHeight() * static_cast<float>(second.line - nextLine)});
+        float nextRow = offsetFirst.y + box.getLineHeight();
+        if (offsetSecond.y > nextRow) {
+            shape.setPosition({lineStart, nextRow});
+            shape.setSize({box.getSize().x - lineStart, offsetSecond.y - nextRow});
 
             target.draw(shape, states);
+            detail::countDrawCall();
         }
 
-        offsetFirst = box.getOffsetOf({second.line, 0});
-        shape.setPosition(offsetFirst);
-        shape.setSize({(box.getOffsetOf(second) - offsetFirst).x, box.getLineHeight()});
+        shape.setPosition({lineStart, offsetSecond.y});
+        shape.setSize({offsetSecond.x - lineStart, box.getLineHeight()});
 
         target.draw(shape, states);
+        detail::countDrawCall();
     }
 
     Highlight::Highlight(TextBox &box, std::shared_ptr<Highlighter> highlighter, const Pos &start, const Pos &end) :
@@ -14,15 +14,13 @@ namespace sftb {
             sf::Clipboard::setString(caret.getSelectedText());
         }
 
-        void removeText(Caret &caret, bool direction) {
-            if(caret.hasSelection()) {
-                caret.removeSelectedText();
-                return;
+        // applies f to every caret, then merges carets which ended up at the same position
+        template<typename F>
+        void forEachCaret(TextBox &box, F f) {
+            for (std::size_t i = 0; i < box.getNumberCarets(); i++) {
+                f(box.getCaret(i));
             }
-
-            auto caretPosition = caret.getPosition();
-            auto removeToPosition = caret.getTextBox().getRelativeCharacters(caretPosition, direction ? -1 : 1);
-            caret.getTextBox().removeText(removeToPosition, caretPosition);
+            box.mergeCarets();
         }
     }
 
@@ -44,7 +42,8 @@ namespace sftb {
                     case sf::Keyboard::C:
                         if (control) {
                             // copy selection, or line
-                            copySelectedOrLine(getTextBox().getPrimaryCaret());
+                            if (getTextBox().getBlockSelection()) sf::Clipboard::setString(getTextBox().getBlockText());
+                            else copySelectedOrLine(getTextBox().getPrimaryCaret());
                         }
                         break;
                     case sf::Keyboard::D:
@@ -52,6 +51,12 @@ namespace sftb {
                             getTextBox().removeLine(getTextBox().getPrimaryCaret().getPosition().line);
                         }
                         break;
+                    case sf::Keyboard::L:
+                        if (control && shift) {
+                            // caret at every occurrence of the selection
+                            getTextBox().selectAllOccurrences();
+                        }
+                        break;
                     case sf::Keyboard::F:
                         if (control) {
                             // todo - find
@@ -64,11 +69,14 @@ namespace sftb {
                         break;
                     case sf::Keyboard::V:
                         if (control) {
-                            getTextBox().getPrimaryCaret().insert(sf::Clipboard::getString());
+                            getTextBox().paste(sf::Clipboard::getString());
                         }
                         break;
                     case sf::Keyboard::X: {
-                        if (control) {
+                        if (control && getTextBox().getBlockSelection()) {
+                            sf::Clipboard::setString(getTextBox().getBlockText());
+                            getTextBox().replaceBlockText("");
+                        } else if (control) {
                             // cut selection, or line
                             Caret &caret = getTextBox().getPrimaryCaret();
                             copySelectedOrLine(caret);
@@ -87,7 +95,9 @@ namespace sftb {
                         }
                         break;
                     case sf::Keyboard::Escape:
-                        getTextBox().getPrimaryCaret().removeSelection();
+                        if (getTextBox().getBlockSelection()) getTextBox().removeBlockSelection();
+                        else if (getTextBox().getNumberCarets() > 1) getTextBox().removeAdditionalCarets();
+                        else getTextBox().getPrimaryCaret().removeSelection();
                         break;
                     case sf::Keyboard::LBracket:
                         // todo - smart brackets
@@ -100,7 +110,11 @@ namespace sftb {
                         break;
                     case sf::Keyboard::Backspace:
                         // remove character to left
-                        removeText(getTextBox().getPrimaryCaret(), true);
+                        if (getTextBox().getBlockSelection()) {
+                            getTextBox().replaceBlockText("");
+                            break;
+                        }
+                        getTextBox().removeAtCarets(-1);
                         // todo - smart brackets (ignore if highlighted)
                         break;
                     case sf::Keyboard::PageUp:
@@ -109,53 +123,58 @@ namespace sftb {
                     case sf::Keyboard::PageDown:
                         // todo
                         break;
-                    case sf::Keyboard::End: {
+                    case sf::Keyboard::End:
                         // move caret to end of line
-                        Caret &caret = getTextBox().getPrimaryCaret();
-                        auto caretLine = caret.getPosition().line;
-                        caret.setPosition({caretLine, getTextBox().getLineLength(caretLine)});
-                    }
+                        forEachCaret(getTextBox(), [](Caret &caret) {
+                            auto caretLine = caret.getPosition().line;
+                            caret.setPosition({caretLine, caret.getTextBox().getLineLength(caretLine)});
+                        });
                         break;
-                    case sf::Keyboard::Home: {
+                    case sf::Keyboard::Home:
                         // move caret to start of line
-                        Caret &caret = getTextBox().getPrimaryCaret();
-                        caret.setPosition({caret.getPosition().line, 0});
-                    }
+                        forEachCaret(getTextBox(), [](Caret &caret) {
+                            caret.setPosition({caret.getPosition().line, 0});
+                        });
                         break;
                     case sf::Keyboard::Delete:
                         // remove character to right
-                        removeText(getTextBox().getPrimaryCaret(), false);
-                        break;
-                    case sf::Keyboard::Left: {
-                        Caret &caret = getTextBox().getPrimaryCaret();
-                        if (shift)
-                            caret.setSelectionEndPos(
-                                    getTextBox().getRelativeCharacters(caret.getSelectionEndPos(), -1));
-                        else caret.setPosition(getTextBox().getRelativeCharacters(caret.getPosition(), -1));
-                    }
-                        break;
-                    case sf::Keyboard::Right: {
-                        Caret &caret = getTextBox().getPrimaryCaret();
-                        if (shift)
-                            caret.setSelectionEndPos(getTextBox().getRelativeCharacters(caret.getSelectionEndPos(), 1));
-                        else caret.setPosition(getTextBox().getRelativeCharacters(caret.getPosition(), 1));
-                    }
-                        break;
-                    case sf::Keyboard::Up: {
-                        Caret &caret = getTextBox().getPrimaryCaret();
-                        if (shift)
-                            caret.setSelectionEndPos(
-                                    getTextBox().getVisibleRelativeLine(caret.getSelectionEndPos(), -1));
-                        else caret.setPosition(getTextBox().getVisibleRelativeLine(caret.getPosition(), -1));
-                    }
-                        break;
-                    case sf::Keyboard::Down: {
-                        Caret &caret = getTextBox().getPrimaryCaret();
-                        if (shift)
-                            caret.setSelectionEndPos(
-                                    getTextBox().getVisibleRelativeLine(caret.getSelectionEndPos(), 1));
-                        else caret.setPosition(getTextBox().getVisibleRelativeLine(caret.getPosition(), 1));
-                    }
+                        if (getTextBox().getBlockSelection()) {
+                            getTextBox().replaceBlockText("");
+                            break;
+                        }
+                        getTextBox().removeAtCarets(1);
+                        break;
+                    case sf::Keyboard::Left:
+                        forEachCaret(getTextBox(), [shift](Caret &caret) {
+                            if (shift)
+                                caret.setSelectionEndPos(
+                                        caret.getTextBox().getRelativeCharacters(caret.getSelectionEndPos(), -1));
+                            else caret.setPosition(caret.getTextBox().getRelativeCharacters(caret.getPosition(), -1));
+                        });
+                        break;
+                    case sf::Keyboard::Right:
+                        forEachCaret(getTextBox(), [shift](Caret &caret) {
+                            if (shift)
+                                caret.setSelectionEndPos(
+                                        caret.getTextBox().getRelativeCharacters(caret.getSelectionEndPos(), 1));
+                            else caret.setPosition(caret.getTextBox().getRelativeCharacters(caret.getPosition(), 1));
+                        });
+                        break;
+                    case sf::Keyboard::Up:
+                        forEachCaret(getTextBox(), [shift](Caret &caret) {
+                            if (shift)
+                                caret.setSelectionEndPos(
+                                        caret.getTextBox().getVisibleRelativeLine(caret.getSelectionEndPos(), -1));
+                            else caret.setPosition(caret.getTextBox().getVisibleRelativeLine(caret.getPosition(), -1));
+                        });
+                        break;
+                    case sf::Keyboard::Down:
+                        forEachCaret(getTextBox(), [shift](Caret &caret) {
+                            if (shift)
+                                caret.setSelectionEndPos(
+                                        caret.getTextBox().getVisibleRelativeLine(caret.getSelectionEndPos(), 1));
+                            else caret.setPosition(caret.getTextBox().getVisibleRelativeLine(caret.getPosition(), 1));
+                        });
                     default:
                         break;
                 }
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <cmath>
+#include "LatencyHistogram.hpp"
+
+namespace sftb {
+    namespace {
+        // number of bits needed to represent value
+        unsigned getBitLength(std::uint64_t value) {
+            unsigned length = 0;
+            for (; value != 0; value >>= 1) length++;
+            return length;
+        }
+    }
+
+    LatencyHistogram::LatencyHistogram() : counts(getBucket(MAX_TRACKABLE) + 1) {
+    }
+
+    std::size_t LatencyHistogram::getBucket(std::uint64_t value) {
+        // values below 2 * SUB_BUCKETS have a bucket each, every following power of two is divided into SUB_BUCKETS
+        // buckets, the value shifted right by `shift` is its index within the power of two (plus SUB_BUCKETS)
+        unsigned length = getBitLength(value);
+        unsigned shift = length > SUB_BUCKET_BITS + 1 ? length - SUB_BUCKET_BITS - 1 : 0;
+        return static_cast<std::size_t>(SUB_BUCKETS * shift + (value >> shift));
+    }
+
+    std::uint64_t LatencyHistogram::getBucketMax(std::size_t bucket) {
+        std::uint64_t shift = bucket < 2 * SUB_BUCKETS ? 0 : bucket / SUB_BUCKETS - 1;
+        std::uint64_t mantissa = bucket - SUB_BUCKETS * shift;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    void LatencyHistogram::record(sf::Time latency) {
+        auto value = static_cast<std::uint64_t>(std::max(sf::Int64(0), latency.asMicroseconds()));
+        value = std::min(value, MAX_TRACKABLE);
+        counts[getBucket(value)]++;
+        totalCount++;
+        max = std::max(max, value);
+    }
+
+    void LatencyHistogram::reset() {
+        std::fill(counts.begin(), counts.end(), 0);
+        totalCount = 0;
+        max = 0;
+    }
+
+    sf::Time LatencyHistogram::getPercentile(double percentile) const {
+        if (totalCount == 0) return sf::Time::Zero;
+
+        auto target = static_cast<std::uint64_t>(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100 * totalCount));
+        target = std::max(target, std::uint64_t(1));
+        std::uint64_t seen = 0;
+        for (std::size_t bucket = 0; bucket < counts.size(); bucket++) {
+            seen += counts[bucket];
+            if (seen >= target) {
+                return sf::microseconds(static_cast<sf::Int64>(std::min(getBucketMax(bucket), max)));
+            }
+        }
+        return getMax();
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef SFML_TEXTBOX_LATENCYHISTOGRAM_HPP
+#define SFML_TEXTBOX_LATENCYHISTOGRAM_HPP
+
+#include <SFML/System/Time.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace sftb {
+    // kinds of events handled by TextBox::handleEvent(), each with its own latency histogram
+    enum class InputEventType {
+        Text, Key, Mouse, Scroll
+    };
+
+    constexpr std::size_t INPUT_EVENT_TYPES = 4;
+
+    /**
+     * Histogram of latencies with a fixed relative precision (HDR histogram style): values are counted in buckets
+     * whose width grows with the value, so that any recorded latency is reported within about 3% of its actual value,
+     * from 1 microsecond up to over an hour, using a few kilobytes.
+     */
+    class LatencyHistogram {
+    private:
+        // each power of two is divided into 2^SUB_BUCKET_BITS buckets
+        static constexpr unsigned SUB_BUCKET_BITS = 5;
+        static constexpr std::uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        // larger values are counted as this value
+        static constexpr std::uint64_t MAX_TRACKABLE = (std::uint64_t(1) << 32) - 1;
+
+        // counts per bucket, in microseconds
+        std::vector<std::uint64_t> counts;
+        std::uint64_t totalCount = 0;
+        std::uint64_t max = 0;
+
+        [[nodiscard]] static std::size_t getBucket(std::uint64_t value);
+        // highest value counted in bucket
+        [[nodiscard]] static std::uint64_t getBucketMax(std::size_t bucket);
+    public:
+        LatencyHistogram();
+
+        void record(sf::Time latency);
+        void reset();
+
+        [[nodiscard]] std::uint64_t getCount() const {
+            return totalCount;
+        }
+
+        // smallest latency which percentile % of the recorded latencies are at or below (rounded up to the precision
+        // of the histogram), 0 if nothing has been recorded
+        [[nodiscard]] sf::Time getPercentile(double percentile) const;
+
+        [[nodiscard]] sf::Time getMax() const {
+            return sf::microseconds(static_cast<sf::Int64>(max));
+        }
+    };
+}
+
+#endif //SFML_TEXTBOX_LATENCYHISTOGRAM_HPP
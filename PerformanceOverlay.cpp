@@ -0,0 +1,57 @@
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <iomanip>
+#include <sstream>
+#include "PerformanceOverlay.hpp"
+#include "TextBox.hpp"
+
+namespace sftb {
+    namespace {
+        constexpr float PADDING = 4;
+
+        double toMilliseconds(sf::Time time) {
+            return static_cast<double>(time.asMicroseconds()) / 1000;
+        }
+    }
+
+    PerformanceOverlay::PerformanceOverlay(const TextBox &box, unsigned characterSize) :
+            box(box.getReference()), text("", box.getFont(), characterSize) {
+        text.setFillColor(sf::Color::White);
+        text.setPosition(PADDING, PADDING);
+        background.setFillColor(sf::Color(0, 0, 0, 160));
+    }
+
+    void PerformanceOverlay::refresh() const {
+        const TextBox &textBox = **box;
+        const FrameInfo &frame = textBox.getLastFrameInfo();
+        text.setFont(textBox.getFont());
+
+        std::ostringstream str;
+        str << std::fixed << std::setprecision(2)
+            << "frame " << toMilliseconds(frame.frameTime) << " ms (draw " << toMilliseconds(frame.drawTime) << " ms)\n"
+            << "draw calls " << frame.drawCalls << ", glyph quads " << frame.glyphQuads << "\n"
+            << "visible highlights " << frame.visibleHighlights << "\n"
+            << "lines " << textBox.getNumberLines() << "\n"
+            << "memory " << static_cast<double>(textBox.getMemoryEstimate()) / (1024 * 1024) << " MiB\n"
+            << "last edit " << toMilliseconds(textBox.getLastEditTime()) << " ms";
+        if (const auto &queue = textBox.getAppendQueue()) {
+            str << "\nappend queue " << queue->getPendingCharacters() << " pending, " << queue->getDroppedTexts()
+                << " dropped";
+        }
+        text.setString(str.str());
+
+        sf::FloatRect bounds = text.getLocalBounds();
+        background.setSize({bounds.left + bounds.width + 2 * PADDING, bounds.top + bounds.height + 2 * PADDING});
+    }
+
+    void PerformanceOverlay::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+        if (!refreshed || sinceRefresh.getElapsedTime() >= refreshInterval) {
+            refresh();
+            refreshed = true;
+            sinceRefresh.restart();
+        }
+
+        states.transform *= getTransform();
+        target.draw(background, states);
+        target.draw(text, states);
+    }
+}
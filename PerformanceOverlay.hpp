@@ -0,0 +1,53 @@
+#ifndef SFML_TEXTBOX_PERFORMANCEOVERLAY_HPP
+#define SFML_TEXTBOX_PERFORMANCEOVERLAY_HPP
+
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/Transformable.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/RectangleShape.hpp>
+#include <SFML/System/Clock.hpp>
+
+namespace sftb {
+    class TextBox;
+
+    /**
+     * Heads-up display of the performance of a TextBox, drawn over it by the host after the TextBox itself:
+     * frame time, draw calls, glyph quads, visible highlights, line count, memory estimate, the cost of the latest
+     * edit and the state of its AppendQueue, if any.
+     * The values are read from the TextBox's last frame and edit measurements, and only refreshed every
+     * getRefreshInterval(), so drawing the overlay costs two draw calls (which are not counted in the TextBox's frame).
+     */
+    class PerformanceOverlay : public sf::Drawable, public sf::Transformable {
+    private:
+        const TextBox *const *box;
+        sf::Time refreshInterval = sf::milliseconds(250);
+        mutable sf::Clock sinceRefresh;
+        mutable bool refreshed = false;
+        mutable sf::Text text;
+        mutable sf::RectangleShape background;
+
+        void refresh() const;
+    protected:
+        void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
+    public:
+        explicit PerformanceOverlay(const TextBox &box, unsigned characterSize = 12);
+
+        [[nodiscard]] sf::Time getRefreshInterval() const {
+            return refreshInterval;
+        }
+
+        void setRefreshInterval(sf::Time interval) {
+            refreshInterval = interval;
+        }
+
+        void setTextColor(const sf::Color &color) {
+            text.setFillColor(color);
+        }
+
+        void setBackgroundColor(const sf::Color &color) {
+            background.setFillColor(color);
+        }
+    };
+}
+
+#endif //SFML_TEXTBOX_PERFORMANCEOVERLAY_HPP
@@ -9,7 +9,7 @@ namespace sftb {
     class Reference {
     public:
         using Ref = T**;
-        using ConstRef = const T**;
+        using ConstRef = const T *const *;
     private:
         std::unique_ptr<T *> pointer;
 
@@ -28,13 +28,14 @@ namespace sftb {
             return *this;
         }
 
+        // other may itself have been moved from, in which case this has no reference either
         Reference(Reference &&other) noexcept: pointer(std::move(other.pointer)) {
-            *pointer = getThis();
+            if (pointer) *pointer = getThis();
         }
 
         Reference &operator=(Reference &&other) noexcept {
             pointer = std::move(other.pointer);
-            *pointer = getThis();
+            if (pointer) *pointer = getThis();
             return *this;
         }
 
@@ -81,6 +81,11 @@ namespace sftb {
 
         void setScroll(float scroll);
 
+        // the scroll as last set, which may be beyond the current content, see getScroll()
+        [[nodiscard]] float getUnboundedScroll() const {
+            return scrollAmount;
+        }
+
         [[nodiscard]] float getScrollOffset() const {
             return -sensitivity * getScroll();
         }
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include "ScrollBarStyle.hpp"
 #include "ScrollBar.hpp"
+#include "Stats.hpp"
 
 namespace sftb {
     float ScrollBarStyle::getPrimary(const ScrollBar &scrollBar, const sf::Vector2f &vector) {
@@ -32,6 +33,7 @@ namespace sftb {
 
         style(rectangle);
         target.draw(rectangle);
+        detail::countDrawCall();
     }
 
     bool StandardScrollBarStyleBase::handleClick(const sf::Vector2f &position, ScrollBar &scrollBar, sf::Mouse::Button button, bool pressed) {
@@ -0,0 +1,96 @@
+#include <cstdlib>
+#include <new>
+#include "Stats.hpp"
+#include "TextBox.hpp"
+
+#ifdef SFTB_ENABLE_STATS
+namespace sftb::detail {
+    // constant initialized, so allocations made before dynamic initialization are counted too
+    StatCounters statCounters;
+}
+
+// replacements of the global allocation functions, counting every allocation
+// the aligned forms are left to the standard library, they are paired with its own aligned deallocation functions
+void *operator new(std::size_t size) {
+    SFTB_STATS_INCREMENT(allocations);
+    if (size == 0) size = 1;
+    while (true) {
+        if (void *pointer = std::malloc(size)) return pointer;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    try {
+        return operator new(size);
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept {
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept {
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept {
+    std::free(pointer);
+}
+#endif
+
+namespace sftb {
+    Stats TextBox::getStats() {
+        Stats stats;
+#ifdef SFTB_ENABLE_STATS
+        const detail::StatCounters &counters = detail::statCounters;
+        stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+        stats.charPosCreated = counters.charPosCreated.load(std::memory_order_relaxed);
+        stats.charPosTransferred = counters.charPosTransferred.load(std::memory_order_relaxed);
+        stats.lineLengthUpdates = counters.lineLengthUpdates.load(std::memory_order_relaxed);
+        stats.linesMoved = counters.linesMoved.load(std::memory_order_relaxed);
+        stats.frames = counters.frames.load(std::memory_order_relaxed);
+        stats.glyphQuads = counters.glyphQuads.load(std::memory_order_relaxed);
+        stats.drawCalls = counters.drawCalls.load(std::memory_order_relaxed);
+#endif
+        return stats;
+    }
+
+    void TextBox::resetStats() {
+#ifdef SFTB_ENABLE_STATS
+        detail::StatCounters &counters = detail::statCounters;
+        counters.allocations.store(0, std::memory_order_relaxed);
+        counters.charPosCreated.store(0, std::memory_order_relaxed);
+        counters.charPosTransferred.store(0, std::memory_order_relaxed);
+        counters.lineLengthUpdates.store(0, std::memory_order_relaxed);
+        counters.linesMoved.store(0, std::memory_order_relaxed);
+        counters.frames.store(0, std::memory_order_relaxed);
+        counters.glyphQuads.store(0, std::memory_order_relaxed);
+        counters.drawCalls.store(0, std::memory_order_relaxed);
+#endif
+    }
+}
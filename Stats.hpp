@@ -0,0 +1,93 @@
+#ifndef SFML_TEXTBOX_STATS_HPP
+#define SFML_TEXTBOX_STATS_HPP
+
+#include <SFML/System/Time.hpp>
+#include <cstddef>
+#ifdef SFTB_ENABLE_STATS
+#include <atomic>
+#endif
+
+namespace sftb {
+    /**
+     * Counters of the work done by all TextBoxes since the last TextBox::resetStats(), see TextBox::getStats().
+     * Counters are only collected when the library is built with SFTB_ENABLE_STATS defined (the cmake option of the
+     * same name), otherwise the instrumentation is compiled out and every counter stays 0.
+     */
+    struct Stats {
+        // heap allocations made through operator new, by any code in the process
+        std::size_t allocations = 0;
+        std::size_t charPosCreated = 0;
+        // CharPos moved to a neighbouring character because the character they referenced was removed
+        std::size_t charPosTransferred = 0;
+        std::size_t lineLengthUpdates = 0;
+        // lines moved in memory, such as when lines are inserted or removed before them
+        std::size_t linesMoved = 0;
+        // calls to TextBox::draw()
+        std::size_t frames = 0;
+        std::size_t glyphQuads = 0;
+        // draw calls made on the render target, drawCalls / frames is the number of draw calls per frame
+        std::size_t drawCalls = 0;
+    };
+
+    // measurements of the last frame drawn by a TextBox, see TextBox::getLastFrameInfo()
+    // unlike Stats, these are always collected
+    struct FrameInfo {
+        // time between the starts of the last two frames
+        sf::Time frameTime;
+        // duration of the last TextBox::draw()
+        sf::Time drawTime;
+        std::size_t drawCalls = 0;
+        std::size_t glyphQuads = 0;
+        std::size_t visibleHighlights = 0;
+    };
+
+#ifdef SFTB_ENABLE_STATS
+    namespace detail {
+        // atomic, as allocations are counted on every thread
+        struct StatCounters {
+            std::atomic<std::size_t> allocations{0};
+            std::atomic<std::size_t> charPosCreated{0};
+            std::atomic<std::size_t> charPosTransferred{0};
+            std::atomic<std::size_t> lineLengthUpdates{0};
+            std::atomic<std::size_t> linesMoved{0};
+            std::atomic<std::size_t> frames{0};
+            std::atomic<std::size_t> glyphQuads{0};
+            std::atomic<std::size_t> drawCalls{0};
+        };
+
+        extern StatCounters statCounters;
+    }
+#endif
+}
+
+// amount is not evaluated when stats are disabled
+#ifdef SFTB_ENABLE_STATS
+#define SFTB_STATS_ADD(counter, amount) \
+    (::sftb::detail::statCounters.counter.fetch_add((amount), std::memory_order_relaxed))
+#else
+#define SFTB_STATS_ADD(counter, amount) ((void) 0)
+#endif
+
+#define SFTB_STATS_INCREMENT(counter) SFTB_STATS_ADD(counter, 1)
+
+namespace sftb::detail {
+    // draw calls and glyph quads of the frame being drawn on this thread
+    struct FrameCounters {
+        std::size_t drawCalls = 0;
+        std::size_t glyphQuads = 0;
+    };
+
+    inline thread_local FrameCounters frameCounters;
+
+    inline void countDrawCall() {
+        frameCounters.drawCalls++;
+        SFTB_STATS_INCREMENT(drawCalls);
+    }
+
+    inline void countGlyphQuads(std::size_t quads) {
+        frameCounters.glyphQuads += quads;
+        SFTB_STATS_ADD(glyphQuads, quads);
+    }
+}
+
+#endif //SFML_TEXTBOX_STATS_HPP
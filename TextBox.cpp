@@ -1,27 +1,51 @@
 #include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/Font.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Graphics/RectangleShape.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
 #include <SFML/Window/Event.hpp>
 #include <cmath>
+#include <algorithm>
+#include <functional>
+#include <unordered_set>
 #include "TextBox.hpp"
 #include "ScrollBarStyle.hpp"
+#include "Trace.hpp"
 
 namespace sftb {
     // used to determine by how much to round when selecting character
     // 0.4 means that, when clicking on a character, there is a 20% preference to the leftmost character
     // 0.5 for no preference
     constexpr float CHARACTER_ROUNDING = 0.4f;
+    // maximum number of lines wrapped outside the visible area per frame
+    constexpr std::size_t WRAP_FILL_LINES = 1024;
+    // number of characters laid out at a time, see Line::layoutUntil()
+    constexpr std::size_t LAYOUT_CHUNK = 1024;
+    // layouts whose advance offsets a line keeps, the least recently used is discarded beyond this
+    constexpr std::size_t LINE_LAYOUTS = 4;
+    // number of characters inserted at a time when pasting, see TextBox::paste()
+    constexpr std::size_t PASTE_SLICE = 1 << 16;
+    constexpr float PASTE_PROGRESS_HEIGHT = 3;
+    // events handled without drawing in between are not measured beyond this number, see TextBox::handleEvent()
+    constexpr std::size_t MAX_PENDING_LATENCIES = 1024;
 
     TextBox::TextBox(sf::Font &font, sf::Vector2f size, std::size_t characterSize, std::shared_ptr<bool> redraw)
-            : font(&font), size(size), characterSize(characterSize),
-              lineHeight(font.getLineSpacing(characterSize)),
-              characterWidth(font.getGlyph('a', characterSize, false).advance),
+            : TextBox(std::make_shared<Document>(), font, size, characterSize, std::move(redraw)) {}
+
+    TextBox::TextBox(std::shared_ptr<Document> document, sf::Font &font, sf::Vector2f size, std::size_t characterSize,
+                     std::shared_ptr<bool> redraw)
+            : document(std::move(document)),
+              font(&font), fontUse(GlyphMetrics::use(font)), characterSize(characterSize),
+              metrics(GlyphMetrics::get(font, characterSize)),
+              layoutId(this->document->getLayoutId(metrics, tabSize)),
+              size(size),
               redraw(redraw ? std::move(redraw) : std::make_shared<bool>(true)),
               scrollBarManager(this->redraw, [box(getReference())]() {
                   return (**box).getContentSize();
               }, [box(getReference())] {
                   return (**box).getSize();
-              }), caret(*this) {
+              }), caret(*this, Caret::Key()),
+              documentObserver(std::make_unique<DocumentObserver>(getReference(), this->document)) {
         inputHandler->textBox = getReference();
     }
 
@@ -31,10 +55,6 @@ namespace sftb {
         }
     }
 
-    bool TextBox::LineLengthCompare::operator()(Line **left, Line **right) const {
-        return (**right).getNumberCharacters() < (**left).getNumberCharacters();
-    }
-
     void TextBox::removeHighlight(const std::shared_ptr<Highlight> &highlight) {
         assert(highlight != nullptr && "highlight is nullptr");
         highlight->box = nullptr;
@@ -48,25 +68,199 @@ namespace sftb {
     }
 
     void TextBox::draw(sf::RenderTarget &target, sf::RenderStates states) const {
+        SFTB_TRACE_SCOPE("draw");
+        auto drawStart = std::chrono::steady_clock::now();
         *redraw = false;
+        SFTB_STATS_INCREMENT(frames);
+        detail::frameCounters = {};
+
+        {
+            SFTB_TRACE_SCOPE("draw background");
+            sf::RectangleShape background(getSize());
+            background.setFillColor(backgroundColor);
+            target.draw(background);
+            detail::countDrawCall();
+        }
+
+        drawText(target, states);
+
+        if (wordWrap) {
+            SFTB_TRACE_SCOPE("wrap lines");
+            // replace estimated visual line counts with exact ones, a few lines at a time
+            std::size_t remaining = WRAP_FILL_LINES;
+            for (; wrapFillLine < getNumberLines() && remaining > 0; wrapFillLine++, remaining--) {
+                getWrapPositions(wrapFillLine);
+            }
+            if (wrapFillLine < getNumberLines()) setRedrawRequired();
+        }
+
+        if (pendingPaste) {
+            sf::RectangleShape progress({getSize().x * getPasteProgress(), PASTE_PROGRESS_HEIGHT});
+            progress.setPosition(0, getSize().y - PASTE_PROGRESS_HEIGHT);
+            progress.setFillColor(sf::Color(255, 255, 255, 128));
+            target.draw(progress, states);
+            detail::countDrawCall();
+        }
+
+        {
+            SFTB_TRACE_SCOPE("draw carets");
+            target.draw(caret, states);
+            for (const std::unique_ptr<Caret> &additional : additionalCarets) {
+                if (isPositionOnScreen(additional->getPosition())) target.draw(*additional, states);
+            }
+        }
+
+        std::size_t visibleHighlights = 0;
+        {
+            SFTB_TRACE_SCOPE("draw highlights");
+            Pos visibleStart = getVisibleStart(), visibleEnd = getVisibleEnd();
+            for (const std::shared_ptr<Highlight> &highlight : highlights) {
+                highlight->draw(target, states);
+                if (overlaps(getPositionOfChar(highlight->getStart()), getPositionOfChar(highlight->getEnd()),
+                             visibleStart, visibleEnd)) {
+                    visibleHighlights++;
+                }
+            }
+            if (blockSelection) drawBlockSelection(target, states);
+        }
+
+        {
+            SFTB_TRACE_SCOPE("draw scroll bars");
+            target.draw(scrollBarManager, states);
+        }
+
+        recordLatencies();
 
-        // draw background
-        sf::RectangleShape background(getSize());
-        background.setFillColor(backgroundColor);
-        target.draw(background);
+        auto drawEnd = std::chrono::steady_clock::now();
+        // no frame time for the first frame
+        lastFrame.frameTime = lastDrawStart == decltype(lastDrawStart)() ? sf::Time::Zero : toTime(drawStart - lastDrawStart);
+        lastFrame.drawTime = toTime(drawEnd - drawStart);
+        lastFrame.drawCalls = detail::frameCounters.drawCalls;
+        lastFrame.glyphQuads = detail::frameCounters.glyphQuads;
+        lastFrame.visibleHighlights = visibleHighlights;
+        lastDrawStart = drawStart;
+    }
 
-        // draw text
-        Pos startPos = getVisibleStart();
-        Pos endPos = getVisibleEnd();
+    std::size_t TextBox::getMemoryEstimate() const {
+        std::size_t size = sizeof(TextBox) + document->getMemoryEstimate() + lineWraps.size() * sizeof(LineWrap);
+        // a line has one visual line besides its wrap positions
+        if (visualLinesValid) size += (visualLines.total() - std::min(visualLines.total(), lineWraps.size())) * sizeof(std::size_t);
+        return size;
+    }
 
-        if (endPos.line > getNumberLines())
-            endPos.line = getNumberLines();
+    void TextBox::handleDocumentChange(const DocumentChange &change) {
+        // if the changed lines are above the first visible row, the scroll is adjusted by the rows they added or
+        // removed so the visible text stays in place (such as when a console removes its oldest lines)
+        ScrollBar &scrollBar = scrollBarManager.getVerticalScrollBar();
+        float scrolled = scrollBar.getUnboundedScroll() * scrollBar.getSensitivity() - offset.y;
+        std::optional<std::size_t> removedRows;
+        std::size_t startRow = change.line;
+        if (follow) {
+            // whether the last row of the document was visible, otherwise the view stays on the same text
+            std::optional<std::size_t> rows;
+            if (!wordWrap) rows = getNumberLines() + change.removedLines - change.insertedLines;
+            else if (visualLinesValid) rows = visualLines.total();
+            if (rows) followPinned = static_cast<float>(*rows) * getLineHeight() - scrolled <= getSize().y;
+        }
+        if (!wordWrap) {
+            if (scrolled > 0 && static_cast<float>(change.line + change.removedLines) * getLineHeight() <= scrolled)
+                removedRows = change.removedLines;
+        } else if (visualLinesValid) {
+            startRow = visualLines.prefixSum(change.line);
+            std::size_t endRow = visualLines.prefixSum(change.line + change.removedLines);
+            if (scrolled > 0 && static_cast<float>(endRow) * getLineHeight() <= scrolled) removedRows = endRow - startRow;
+        }
+
+        if (wordWrap) {
+            // lines kept in place changed, the others were inserted or removed
+            bool toEnd = change.line + change.removedLines == lineWraps.size();
+            auto first = lineWraps.begin() + static_cast<std::ptrdiff_t>(change.line);
+            std::size_t kept = std::min(change.removedLines, change.insertedLines);
+            std::for_each(first, first + kept, [](LineWrap &wrap) {
+                wrap.generation = 0;
+            });
+            if (change.removedLines > kept) lineWraps.erase(first + kept, first + change.removedLines);
+            else lineWraps.insert(first + kept, change.insertedLines - kept, LineWrap());
+            assert(lineWraps.size() == getNumberLines() && "document change does not match the number of lines");
+
+            // keep the visual line index up to date rather than rebuilding it, unless lines were inserted or removed
+            // in the middle of the document
+            if (visualLinesValid) {
+                if (change.removedLines == change.insertedLines) {
+                    for (std::size_t line = change.line; line < change.line + kept; line++) getWrapPositions(line);
+                } else if (change.line == 0 && change.insertedLines == 0) visualLines.popFront(change.removedLines);
+                else if (toEnd) {
+                    // the new lines are estimated, as in ensureVisualLines()
+                    visualLines.truncate(change.line);
+                    for (std::size_t line = change.line; line < getNumberLines(); line++) {
+                        lineWraps[line].indexedVisualLines = estimateVisualLines(line);
+                        visualLines.pushBack(lineWraps[line].indexedVisualLines);
+                    }
+                } else invalidateVisualLines();
+            }
+            // lines which changed in place are wrapped again
+            if (kept == 0 && wrapFillLine >= change.line + change.removedLines)
+                wrapFillLine = wrapFillLine - change.removedLines + change.insertedLines;
+            else wrapFillLine = std::min(wrapFillLine, change.line);
+        }
+
+        if (removedRows) {
+            std::size_t insertedRows = change.insertedLines;
+            if (wordWrap) {
+                ensureVisualLines();
+                insertedRows = visualLines.prefixSum(change.line + change.insertedLines) - startRow;
+            }
+            if (insertedRows != *removedRows) {
+                float rows = static_cast<float>(insertedRows) - static_cast<float>(*removedRows);
+                scrollBar.setScroll(scrollBar.getUnboundedScroll() + rows * getLineHeight() / scrollBar.getSensitivity());
+            }
+        }
+        // the content size is known without going through the lines, so following costs the same for every change
+        if (follow && followPinned) scrollBar.setScroll(scrollBar.getMaxScroll());
 
-        unsigned line = startPos.line;
+        if (widestLine >= change.line + change.removedLines) {
+            widestLine = widestLine - change.removedLines + change.insertedLines;
+        } else if (widestLine >= change.line) widestLineWidth = 0;
+
+        if (blockSelection && blockSelection->lastLine >= getNumberLines()) removeBlockSelection();
+        setRedrawRequired();
+    }
+
+    void TextBox::drawText(sf::RenderTarget &target, sf::RenderStates states) const {
+        SFTB_TRACE_SCOPE("draw text");
+        float lineHeight = getLineHeight();
+        auto visualLine = static_cast<std::size_t>(std::max(0.0f, -getTextOffsetVertical() / lineHeight));
+        auto visualEnd = std::min(getNumberVisualLines(), static_cast<std::size_t>(
+                std::max(0.0f, std::ceil((getSize().y - getTextOffsetVertical()) / lineHeight))));
+
+        for (; visualLine < visualEnd; visualLine++) {
+            std::size_t line, position, visibleEnd;
+            if (wordWrap) {
+                VisualLine visual = getVisualLine(visualLine);
+                line = visual.line;
+                position = visual.start;
+                visibleEnd = visual.end;
+            } else {
+                // characters have different widths, so the visible columns differ per line
+                line = visualLine;
+                position = getLinePositionAt(line, -getTextOffsetHorizontal());
+                visibleEnd = getLinePositionAt(line, getSize().x - getTextOffsetHorizontal(), 1);
+
+                float width = getLine(line).getWidth(*this);
+                if (width > widestLineWidth) {
+                    widestLine = line;
+                    widestLineWidth = width;
+                }
+            }
+
+            while (position < visibleEnd && position < getLineLength(line)) {
+                const Line &lineInfo = getLine(line);
+                // tabs are not drawn, the layout already advanced to the next tab stop
+                if (lineInfo.getChar(position) == '\t') {
+                    position++;
+                    continue;
+                }
 
-        while (line < endPos.line) {
-            unsigned position = startPos.position;
-            while (position < endPos.position && position < getLineLength(line)) {
                 // text style end
                 Pos currentPosition{line, position};
                 // todo
@@ -75,8 +269,15 @@ namespace sftb {
                 TextStyle style(redraw, sf::Color::White, false, false, false, false);
                 Pos styleEnd = getEndPos();
 
-                std::size_t lineEnd = std::min(endPos.position, getLineLength(line));
+                std::size_t lineEnd = std::min(visibleEnd, getLineLength(line));
                 std::size_t partEnd = styleEnd.line == line ? std::min(styleEnd.position, lineEnd) : lineEnd;
+                // sf::Text expands tabs to a fixed width rather than to tab stops, end the part at the next tab
+                for (std::size_t i = position + 1; i < partEnd; i++) {
+                    if (lineInfo.getChar(i) == '\t') {
+                        partEnd = i;
+                        break;
+                    }
+                }
 
                 sf::Text text(getTextFrom({line, position}, {line, partEnd}), *font, characterSize);
                 text.setFillColor(style.getTextColor());
@@ -90,294 +291,340 @@ namespace sftb {
                 // SFML draws text somewhat blurry if it's not aligned to an integer, floor the offset
                 text.setPosition(std::floor(drawOffset.x), std::floor(drawOffset.y));
                 target.draw(text, states);
+                detail::countDrawCall();
+                // sf::Text generates a quad for every character other than whitespace
+                detail::countGlyphQuads(partEnd - position - std::count_if(
+                        lineInfo.getText() + position, lineInfo.getText() + partEnd, [](Char c) {
+                            return c == ' ' || c == '\n' || c == '\t';
+                        }));
                 position = partEnd;
             }
-
-            line++;
         }
-
-        target.draw(caret, states);
-
-        for (const std::shared_ptr<Highlight> &highlight : highlights) {
-            highlight->draw(target, states);
-        }
-
-        target.draw(scrollBarManager, states);
     }
 
     sf::Vector2f TextBox::getContentSize() const {
         return offset + sf::Vector2f{
-                (getLongestLineLength() + 0.5f) * getCharacterWidth(),
-                (getNumberLines() + 0.5f) * getLineHeight()
+                wordWrap ? getWrapWidth() : getLongestLineWidth() + 0.5f * getCharacterWidth(),
+                (getNumberVisualLines() + 0.5f) * getLineHeight()
         };
     }
 
-    Pos TextBox::getVisibleStart() const {
-        return getPositionAt(0, 0);
-    }
+    Pos TextBox::getPositionAt(float xOffset, float yOffset, float roundX, float roundY) const {
+        xOffset -= getTextOffsetHorizontal();
+        yOffset -= getTextOffsetVertical();
 
-    Pos TextBox::getVisibleEnd() const {
-        return getPositionAt(getSize(), 0.5f, 0.5f);
+        if (roundY != 0) yOffset += roundY * getLineHeight();
+
+        auto visualLine = static_cast<std::size_t>(std::max(0, static_cast<int>(yOffset / getLineHeight())));
+        return getPositionInVisualLine(visualLine, xOffset, roundX);
     }
 
-    bool TextBox::isPositionOnScreen(const Pos &position) const {
-        return getVisibleStart() <= position && position < getVisibleEnd();
+    sf::Vector2f TextBox::getOffsetOf(const Pos &pos) const {
+        float x = getLineOffset(pos);
+        if (wordWrap && pos.line < getNumberLines()) {
+            // relative to the start of the visual line
+            x -= getLine(pos.line).getOffset(*this, getVisualLineStart(pos.line, getVisualLineWithin(pos.line, pos.position)));
+        }
+
+        return {
+                getTextOffsetHorizontal() + x,
+                getTextOffsetVertical() + static_cast<float>(getVisualLineOf(pos)) * getLineHeight()
+        };
     }
 
-    Pos TextBox::getRelativeCharacters(Pos pos, int characters) const {
-        if (characters < 0) {
-            characters = -characters;
-            do {
-                if (pos.position >= characters) {
-                    pos.position -= characters;
-                    return pos;
-                }
+    Pos TextBox::getPositionInVisualLine(std::size_t visualLine, float xOffset, float roundX) const {
+        if (!wordWrap) return {visualLine, getLinePositionAt(visualLine, xOffset, roundX)};
 
-                if (pos.line == 0) {
-                    pos.position = 0;
-                    return pos;
-                }
+        VisualLine visual = getVisualLine(visualLine);
+        if (visual.line >= getNumberLines()) return {visual.line, getLinePositionAt(visual.line, xOffset, roundX)};
 
-                characters -= static_cast<int>(pos.position) + 1;
-                pos.position = getLineLength(--pos.line);
-            } while (characters > 0);
-        } else {
-            do {
-                std::size_t lengthLine = getLineLength(pos.line);
-                if (lengthLine - pos.position >= characters) {
-                    pos.position += characters;
-                    return pos;
-                }
+        const Line &line = getLine(visual.line);
+        std::size_t position = line.getPositionAt(*this, xOffset + line.getOffset(*this, visual.start), roundX);
+        // the end of a visual line is the start of the next one; stay on this visual line unless it's the last
+        std::size_t end = visual.end == line.getNumberCharacters() ? visual.end : std::max(visual.start, visual.end - 1);
+        return {visual.line, std::clamp(position, visual.start, end)};
+    }
 
-                if (pos.line == getNumberLines()) {
-                    pos.position = 0;
-                    return pos;
-                }
+    std::size_t TextBox::getNumberVisualLines() const {
+        if (!wordWrap) return getNumberLines();
+        ensureVisualLines();
+        return visualLines.total();
+    }
 
-                characters -= static_cast<int>(lengthLine - pos.position) + 1;
-                pos.position = 0;
-                pos.line++;
-            } while (characters > 0);
-        }
+    std::size_t TextBox::getVisualLineOf(const Pos &pos) const {
+        if (!wordWrap) return pos.line;
+        if (pos.line >= getNumberLines()) return getNumberVisualLines() + pos.line - getNumberLines();
 
-        return pos;
+        ensureVisualLines();
+        // wrap the line first; updating its number of visual lines does not affect the lines before it
+        std::size_t lineVisual = getVisualLineWithin(pos.line, pos.position);
+        return visualLines.prefixSum(pos.line) + lineVisual;
     }
 
-    Pos TextBox::getRelativeLine(Pos pos, int lineAmount) const {
-        if (lineAmount > 0) {
-            pos.line += lineAmount;
-            if (pos.line >= getNumberLines()) return getEndPos();
-        } else {
-            lineAmount = -lineAmount;
-            if (lineAmount == pos.line)
-                pos.line = 0;
-            else if (lineAmount > pos.line) return getStartPos();
-            else pos.line -= lineAmount;
+    TextBox::VisualLine TextBox::getVisualLine(std::size_t visualLine) const {
+        ensureVisualLines();
+        while (true) {
+            std::size_t total = visualLines.total();
+            if (visualLine >= total) return {getNumberLines() + visualLine - total, 0, 0};
+
+            std::size_t lineIndex = visualLines.search(visualLine);
+            std::size_t lineVisual = visualLine - visualLines.prefixSum(lineIndex);
+            // wrapping the line may correct its estimated number of visual lines; if the estimate was too high, search
+            // again with the updated index
+            if (lineVisual < getNumberVisualLines(lineIndex))
+                return {lineIndex, getVisualLineStart(lineIndex, lineVisual), getVisualLineEnd(lineIndex, lineVisual)};
         }
-        pos.position = std::min(pos.position, getLineLength(pos.line));
-        return pos;
     }
 
-    Pos TextBox::getVisibleRelativeLine(Pos pos, int lineAmount) const {
-        Pos relativePosition = getRelativeLine(pos, lineAmount);
-        // if getRelativeLine needs to modify the position, use that value instead
-        if (relativePosition.position != pos.position) return relativePosition;
-
-        auto line = relativePosition.line;
-        float xPos = getOffsetOf(pos).x;
-        auto position = getPositionAt(xPos, line * getLineHeight(), CHARACTER_ROUNDING).position;
-        return {line, std::min(position, getLineLength(line))};
+    float TextBox::getWrapWidth() const {
+        float reserved = scrollBarManager.getVerticalScrollBar().getScrollBarStyle().getReservedWidth();
+        return std::max(getCharacterWidth(), getSize().x - offset.x - reserved);
     }
 
-    void TextBox::setScrollTo(const Pos &position) {
-        // todo
-//        sf::Vector2f positionOffset = getOffsetOf(position);
-//        scrollBarManager.getHorizontalScrollBar().setScrollPercent(positionOffset.x / scrollBarManager.getHorizontalScrollBar().getMaxScrollOffset());
-//        scrollBarManager.getVerticalScrollBar().setScrollPercent(positionOffset.y / scrollBarManager.getVerticalScrollBar().getMaxScrollOffset());
+    void TextBox::invalidateWrap() {
+        if (++wrapGeneration == 0) wrapGeneration = 1;
+        invalidateVisualLines();
+        wrapFillLine = 0;
+        setRedrawRequired();
     }
 
-    std::size_t TextBox::getLineLength(std::size_t line) const {
-        return line == getNumberLines() ? 0 : getLine(line).getNumberCharacters();
+    void TextBox::ensureVisualLines() const {
+        if (visualLinesValid) return;
+        // lines which have not been wrapped since the last change use an estimate
+        visualLines.build(getNumberLines(), [this](std::size_t index) {
+            LineWrap &wrap = lineWraps[index];
+            wrap.indexedVisualLines = wrap.generation == wrapGeneration ? wrap.positions.size() + 1 : estimateVisualLines(index);
+            return wrap.indexedVisualLines;
+        });
+        visualLinesValid = true;
     }
 
-    CharPos TextBox::getCharPos(const Pos &pos) {
-        if (pos == getEndPos()) return endCharPosDataHolder.getCharPos(nullptr, nullptr);
+    void TextBox::updateVisualLines(std::size_t line, std::size_t rows) const {
+        LineWrap &wrap = lineWraps[line];
+        if (!visualLinesValid || rows == wrap.indexedVisualLines) return;
+        // unsigned arithmetic, wraps around to subtract when rows decreased
+        visualLines.add(line, rows - wrap.indexedVisualLines);
+        wrap.indexedVisualLines = rows;
+    }
 
-        Line &line = getLine(pos.line);
-        if (pos.position == line.getNumberCharacters())
-            return line.endLineCharPosDataHolder.getCharPos(&line, nullptr);
+    float TextBox::getLineOffset(const Pos &pos) const {
+        if (pos.line >= getNumberLines()) return static_cast<float>(pos.position) * getCharacterWidth();
+        return getLine(pos.line).getOffset(*this, pos.position);
+    }
 
-        CharInfo &info = line.getCharInfo(pos.position);
-        return info.referenceHolder.getCharPos(&line, &info);
+    std::size_t TextBox::getLinePositionAt(std::size_t line, float xOffset, float roundX) const {
+        if (line >= getNumberLines())
+            return static_cast<std::size_t>(std::max(0, static_cast<int>(xOffset / getCharacterWidth() + roundX)));
+        return getLine(line).getPositionAt(*this, xOffset, roundX);
     }
 
-    namespace detail {
-        void CharPosDataHolder::transfer(const CharPos &pos) {
-            if (active()) {
-                reference.lock()->setRelative(pos);
-                reference.reset();
-            }
-        }
+    void TextBox::updateGlyphMetrics() {
+        metrics = GlyphMetrics::get(*font, characterSize);
+        invalidateLayout();
+    }
 
-        CharPos CharPosDataHolder::getCharPos(Line *line, CharInfo *info) {
-            if (active()) return reference.lock();
-            CharPos charPos = std::make_shared<CharPosData>(line == nullptr ? nullptr : line->getReference(), info);
-            reference = charPos;
-            return charPos;
-        }
+    void TextBox::invalidateLayout() {
+        // lines are laid out again lazily, as they are used
+        layoutId = document->getLayoutId(metrics, tabSize);
+        widestLineWidth = 0;
+        if (wordWrap) invalidateWrap();
+        setRedrawRequired();
+    }
 
-        void CharPosDataHolder::updateLine(Line &line) {
-            if (active()) reference.lock()->updateLine(line.getReference());
-        }
+    Pos TextBox::getVisibleStart() const {
+        return getPositionAt(0, 0);
+    }
 
-        void CharPosDataHolder::updateCharInfo(CharInfo *info) {
-            if (active()) reference.lock()->updateCharInfo(info);
-        }
+    Pos TextBox::getVisibleEnd() const {
+        return getPositionAt(getSize(), 0.5f, 0.5f);
     }
 
-    namespace {
-        void order(Pos &first, Pos &second) {
-            if (second < first)
-                std::swap(first, second);
-        }
+    bool TextBox::isPositionOnScreen(const Pos &position) const {
+        return getVisibleStart() <= position && position < getVisibleEnd();
     }
 
-    sf::String TextBox::getTextFrom(Pos first, Pos second) const {
-        if (first == second) return "";
-        order(first, second);
+    Pos TextBox::getVisibleRelativeLine(Pos pos, int lineAmount) const {
+        if (wordWrap) {
+            float xPos = getOffsetOf(pos).x - getTextOffsetHorizontal();
+            auto visualLine = static_cast<long long>(getVisualLineOf(pos)) + lineAmount;
+            if (visualLine < 0) return getStartPos();
+            if (visualLine >= static_cast<long long>(getNumberVisualLines())) return getEndPos();
+            return getPositionInVisualLine(visualLine, xPos, CHARACTER_ROUNDING);
+        }
 
-        if (first.line == second.line) return getLineContents(first.line, first.position, second.position);
+        Pos relativePosition = getRelativeLine(pos, lineAmount);
+        // if getRelativeLine needs to modify the position, use that value instead
+        if (relativePosition.position != pos.position) return relativePosition;
 
-        sf::String str;
+        auto line = relativePosition.line;
+        auto position = getLinePositionAt(line, getLineOffset(pos), CHARACTER_ROUNDING);
+        return {line, std::min(position, getLineLength(line))};
+    }
 
-        unsigned line = first.line;
-        unsigned startIndex = first.position;
+    void TextBox::setScrollTo(const Pos &position) {
+        sf::Vector2f positionOffset = getOffsetOf(position);
+        // distance the text needs to move for position (and its line) to be within the visible area, scroll offsets
+        // are negative
+        ScrollBar &horizontal = scrollBarManager.getHorizontalScrollBar();
+        if (positionOffset.x < offset.x) {
+            horizontal.setScrollOffset(horizontal.getScrollOffset() + offset.x - positionOffset.x);
+        } else if (positionOffset.x + getCharacterWidth() > getSize().x) {
+            horizontal.setScrollOffset(horizontal.getScrollOffset() + getSize().x - positionOffset.x - getCharacterWidth());
+        }
 
-        while (line < second.line) {
-            str += getLineContents(line, startIndex) + '\n';
-            line++;
-            startIndex = 0;
+        ScrollBar &vertical = scrollBarManager.getVerticalScrollBar();
+        if (positionOffset.y < offset.y) {
+            vertical.setScrollOffset(vertical.getScrollOffset() + offset.y - positionOffset.y);
+        } else if (positionOffset.y + getLineHeight() > getSize().y) {
+            vertical.setScrollOffset(vertical.getScrollOffset() + getSize().y - positionOffset.y - getLineHeight());
         }
+    }
 
-        str += getLineContents(second.line, 0, second.position);
-        return str;
+    void TextBox::setFollow(bool f) {
+        follow = f;
+        if (!follow) return;
+        followPinned = true;
+        ScrollBar &scrollBar = scrollBarManager.getVerticalScrollBar();
+        scrollBar.setScroll(scrollBar.getMaxScroll());
     }
 
-    sf::String TextBox::getLineContents(std::size_t lineNumber, std::size_t start, std::size_t end) const {
-        if (lineNumber == getNumberLines()) return "";
+    Pos TextBox::insertText(Pos pos, const sf::String &text) {
+        EditTimer timer(*this);
+        return document->insertText(pos, text);
+    }
+
+    std::vector<Pos> TextBox::insertText(const std::vector<Pos> &positions, const sf::String &text) {
+        EditTimer timer(*this);
+        return document->insertText(positions, text);
+    }
 
-        const Line &line = getLine(lineNumber);
-        // ensure start < end
-        if (end < start)
-            std::swap(start, end);
-        // ensure start and end within bounds
-        start = std::min(start, line.getNumberCharacters());
-        end = std::min(end, line.getNumberCharacters());
+    void TextBox::paste(sf::String text) {
+        finishPaste();
+        caret.removeSelectedText();
+        if (text.isEmpty()) return;
 
-        sf::String str;
-        while (start < end) {
-            str += line.getCharInfo(start).getChar();
-            start++;
+        if (text.getSize() <= PASTE_SLICE) {
+            caret.insert(text);
+            return;
         }
 
-        return str;
+        // the first slice is inserted immediately, the rest is anchored to its last character
+        pendingPaste = PendingPaste{std::move(text), 0, CharPos()};
+        continuePaste();
     }
 
-#define ASSERT_POSITION(pos) \
-    assert((pos).line <= getNumberLines() && #pos " line out of bounds"); \
-    assert((pos).position <= getLineLength((pos).line) && #pos " position out of bounds");
+    void TextBox::continuePaste() {
+        PendingPaste &paste = *pendingPaste;
+        Pos pos = paste.inserted == 0 ? caret.getPosition() :
+                  getRelativeCharacters(getPositionOfChar(paste.last), 1);
+
+        std::size_t count = std::min(PASTE_SLICE, paste.text.getSize() - paste.inserted);
+        const Char *slice = paste.text.getData() + paste.inserted;
+        Pos end = insertText(pos, std::basic_string<Char>(slice, slice + count));
+        paste.inserted += count;
+
+        if (paste.inserted < paste.text.getSize()) {
+            // slices are never empty, so there is always a character (or line break) before end
+            paste.last = getCharPos(getRelativeCharacters(end, -1));
+            // the caret, anchored to the character after it, was moved past the first slice. It is put back before the
+            // text, where the following slices do not move it, until the paste is finished
+            if (count == paste.inserted) caret.setPosition(pos);
+            return;
+        }
 
-    Pos TextBox::insertText(Pos pos, const sf::String &text) {
-        ASSERT_POSITION(pos)
-        setRedrawRequired();
+        pendingPaste.reset();
+        caret.setPosition(end);
+        if (!isPositionOnScreen(end)) setScrollTo(end);
+    }
 
-        std::size_t startIndex = 0;
-        std::size_t endIndex = text.find('\n');
+    void TextBox::finishPaste() {
+        while (pendingPaste) continuePaste();
+    }
 
-        if (endIndex != sf::String::InvalidPos) {
-            if (pos.line == getNumberLines()) lines.emplace_back(this);
-            Line &next = *lines.emplace(lines.begin() + pos.line + 1, this);
+    float TextBox::getPasteProgress() const {
+        if (!pendingPaste) return 1;
+        return static_cast<float>(pendingPaste->inserted) / static_cast<float>(pendingPaste->text.getSize());
+    }
 
-            Line &startLine = getLine(pos.line);
-            startLine.move(next, pos.position, 0);
-            startLine.insert(text.substring(0, endIndex), pos.position);
+    std::shared_ptr<FileLoader> TextBox::loadFile(const std::string &path) {
+        if (fileLoader) fileLoader->cancel();
+        removeLines(0, static_cast<unsigned>(getNumberLines()));
+        fileLoader = std::make_shared<FileLoader>(path);
+        return fileLoader;
+    }
 
-            pos.position = endIndex;
-            startIndex = endIndex + 1;
+    std::shared_ptr<FileFollower> TextBox::followFile(const std::string &path, bool skipExisting) {
+        fileFollower = std::make_shared<FileFollower>(path, skipExisting);
+        return fileFollower;
+    }
 
-            while ((endIndex = text.find('\n', endIndex + 1)) != sf::String::InvalidPos) {
-                pos.position = endIndex - startIndex;
-                lines.emplace(lines.begin() + ++pos.line, this)->insert(text.substring(startIndex, pos.position));
-                startIndex = endIndex + 1;
-            }
-            pos.line++;
+    void TextBox::update() {
+        if (appendQueue) {
+            // everything pushed since the last update is appended at once
+            sf::String text = appendQueue->drain();
+            if (!text.isEmpty()) append(text);
+        }
 
-            return pos;
+        if (fileFollower) {
+            sf::Clock clock;
+            do {
+                FileFollower::Update followed = fileFollower->takeUpdate();
+                if (followed.reset) removeLines(0, static_cast<unsigned>(getNumberLines()));
+                if (followed.text.isEmpty()) break;
+                append(followed.text);
+            } while (clock.getElapsedTime() < loadTimeBudget);
         }
 
-        getOrInsertLine(pos.line).insert(text.substring(startIndex), pos.position);
-        return {pos.line, pos.position + text.getSize() - startIndex};
+        if (fileLoader) {
+            sf::Clock clock;
+            do {
+                std::optional<sf::String> chunk = fileLoader->takeChunk();
+                if (!chunk) break;
+                append(*chunk);
+            } while (clock.getElapsedTime() < loadTimeBudget);
+            if (fileLoader->isDone()) fileLoader.reset();
+        }
+
+        if (!pendingPaste) return;
+        sf::Clock clock;
+        do {
+            continuePaste();
+        } while (pendingPaste && clock.getElapsedTime() < pasteTimeBudget);
     }
 
     Pos TextBox::insertLine(unsigned line, const sf::String &string) {
-        assert(line <= getNumberLines() && "line out of bounds");
-        lines.emplace(lines.begin() + line, this);
-        return insertText({line, 0}, string);
+        EditTimer timer(*this);
+        return document->insertLine(line, string);
     }
 
     void TextBox::removeText(Pos from, Pos to) {
-        if (from == to) return;
-        order(from, to);
-        ASSERT_POSITION(from)
-        ASSERT_POSITION(to)
-        setRedrawRequired();
-
-        if (from.line == to.line) {
-            getLine(from.line).remove(from.position, to.position);
-            return;
-        }
-
-        Line &fromLine = getLine(from.line);
-        if (from.position != fromLine.getNumberCharacters())
-            fromLine.remove(from.position);
-        unsigned line = from.line + 1;
-
-        removeLines(line, to.line);
-        to.line = line;
-
-        if (to.position != 0) {
-            getLine(to.line).remove(0, to.position);
-        }
+        EditTimer timer(*this);
+        document->removeText(from, to);
+    }
 
-        if (to.line != getNumberLines()) {
-            Line &toLine = getLine(to.line);
-            if (toLine.getNumberCharacters() > 0) {
-                // move line contents from to -> from.line directly after from
-                toLine.move(fromLine, 0, from.position);
-            }
-            removeLine(to.line);
-        }
+    std::vector<Pos> TextBox::removeText(const std::vector<std::pair<Pos, Pos>> &ranges) {
+        EditTimer timer(*this);
+        return document->removeText(ranges);
     }
 
     void TextBox::removeLine(unsigned int line) {
-        getLine(line).prepareRemoveAll(getTransferPos(line, line + 1));
-        lines.erase(lines.begin() + line);
+        EditTimer timer(*this);
+        document->removeLine(line);
     }
 
     void TextBox::removeLines(unsigned int start, unsigned int end) {
-        assert(start <= getNumberLines() &&
-               "start out of bounds"); // could omit check (implied by checks below) but may help debugging
-        assert(end <= getNumberLines() && "end out of bounds");
-        assert(start <= end && "start must be before end");
-        // todo - try and optimize -- iterating over each removed character from each removed line in case
-        //  transfer is required is fairly inefficient
-        CharPos transfer = getTransferPos(start, end);
-        auto iterStart = lines.begin() + start;
-        auto iterEnd = lines.begin() + end;
-        for (auto iter = iterStart; iter < iterEnd; iter++) {
-            iter->prepareRemoveAll(transfer);
-        }
-        lines.erase(iterStart, iterEnd);
+        EditTimer timer(*this);
+        document->removeLines(start, end);
+    }
+
+    Pos TextBox::append(const sf::String &text) {
+        EditTimer timer(*this);
+        return document->append(text);
+    }
+
+    void TextBox::reloadText(const sf::String &content) {
+        EditTimer timer(*this);
+        document->reloadText(content);
     }
 
     bool TextBox::isOutBounds(bool verify, int x, int y) const {
@@ -385,42 +632,281 @@ namespace sftb {
     }
 
     void TextBox::handleEvent(const sf::Event &event, bool verifyArea) {
+        SFTB_TRACE_SCOPE("handleEvent");
+        if (eventRecorder) eventRecorder->record(event, verifyArea);
+        auto received = std::chrono::steady_clock::now();
+
+        // the redraw flag is cleared while the event is handled, so it shows whether the event changed anything
+        bool redrawPending = isRedrawRequired();
+        *redraw = false;
+        std::optional<InputEventType> type = dispatchEvent(event, verifyArea);
+        bool changed = isRedrawRequired();
+        if (redrawPending) setRedrawRequired();
+
+        // the latency is recorded once a frame has been drawn, events which did not change anything are not measured
+        if (type && changed && pendingLatencies.size() < MAX_PENDING_LATENCIES) {
+            pendingLatencies.emplace_back(*type, received);
+        }
+    }
+
+    std::optional<InputEventType> TextBox::dispatchEvent(const sf::Event &event, bool verifyArea) {
         if (event.type == sf::Event::KeyPressed) {
             handleInput(event.key.code, true, event.key.control, event.key.shift, event.key.alt);
+            return InputEventType::Key;
         } else if (event.type == sf::Event::KeyReleased) {
             handleInput(event.key.code, false, event.key.control, event.key.shift, event.key.alt);
+            return InputEventType::Key;
         } else if (event.type == sf::Event::TextEntered) {
             if (inputHandler->isTextInput(event.text.unicode)) {
                 sf::String string;
-                // todo - remove replacing tab with spaces when support for non-monospaced characters are added
-                if (event.text.unicode == '\t') string = "    ";
-                    // convert carriage return to newline
-                else if (event.text.unicode == '\r') string = '\n';
+                // convert carriage return to newline
+                if (event.text.unicode == '\r') string = '\n';
                 else string = event.text.unicode;
                 handleTextInput(string);
             }
+            return InputEventType::Text;
         } else if (event.type == sf::Event::MouseWheelScrolled) {
-            if (isOutBounds(verifyArea, event.mouseWheelScroll.x, event.mouseWheelScroll.y)) return;
+            if (isOutBounds(verifyArea, event.mouseWheelScroll.x, event.mouseWheelScroll.y)) return std::nullopt;
 
             handleScroll(event.mouseWheelScroll.wheel == sf::Mouse::Wheel::VerticalWheel, event.mouseWheelScroll.delta);
+            return InputEventType::Scroll;
         } else if (event.type == sf::Event::MouseButtonPressed) {
-            if (isOutBounds(verifyArea, event.mouseButton.x, event.mouseButton.y)) return;
+            if (isOutBounds(verifyArea, event.mouseButton.x, event.mouseButton.y)) return std::nullopt;
 
             handleInput(event.mouseButton.button, true, event.mouseButton.x, event.mouseButton.y);
+            return InputEventType::Mouse;
         } else if (event.type == sf::Event::MouseButtonReleased) {
             // no checks to isOutBounds (mouse release is to end selection)
             handleInput(event.mouseButton.button, false, event.mouseButton.x, event.mouseButton.y);
+            return InputEventType::Mouse;
         } else if (event.type == sf::Event::MouseMoved) {
             handleMousePositionChange(event.mouseMove.x, event.mouseMove.y);
+            return InputEventType::Mouse;
+        }
+        return std::nullopt;
+    }
+
+    void TextBox::recordLatencies() const {
+        auto drawn = std::chrono::steady_clock::now();
+        for (const auto &[type, received] : pendingLatencies) {
+            latencyHistograms[static_cast<std::size_t>(type)].record(toTime(drawn - received));
         }
+        pendingLatencies.clear();
+    }
+
+    void TextBox::resetLatencyHistograms() {
+        for (LatencyHistogram &histogram : latencyHistograms) histogram.reset();
+        pendingLatencies.clear();
     }
 
     void TextBox::handleInput(sf::Keyboard::Key key, bool pressed, bool control, bool shift, bool alt) {
+        // the flags of the event releasing a modifier may still include it
+        if (key == sf::Keyboard::LControl || key == sf::Keyboard::RControl) controlHeld = pressed;
+        else controlHeld = control;
+        if (key == sf::Keyboard::LAlt || key == sf::Keyboard::RAlt) altHeld = pressed;
+        else altHeld = alt;
         inputHandler->handle(key, pressed, control, shift, alt);
     }
 
     void TextBox::handleTextInput(const sf::String &string) {
-        caret.insert(string);
+        if (blockSelection) replaceBlockText(string);
+        else insertAtCarets(string);
+    }
+
+    Caret &TextBox::addCaret(const Pos &position) {
+        additionalCarets.emplace_back(std::make_unique<Caret>(*this, Caret::Key()));
+        Caret &added = *additionalCarets.back();
+        added.setPosition(position);
+        return added;
+    }
+
+    void TextBox::removeAdditionalCarets() {
+        if (additionalCarets.empty()) return;
+        additionalCarets.clear();
+        setRedrawRequired();
+    }
+
+    namespace {
+        // carets ordered by position, with the primary caret first among carets at the same position
+        std::vector<std::pair<Pos, Caret *>> getSortedCarets(TextBox &box) {
+            std::vector<std::pair<Pos, Caret *>> carets;
+            carets.reserve(box.getNumberCarets());
+            for (std::size_t i = 0; i < box.getNumberCarets(); i++) {
+                carets.emplace_back(box.getCaret(i).getPosition(), &box.getCaret(i));
+            }
+            std::stable_sort(carets.begin(), carets.end(), [](const auto &first, const auto &second) {
+                return first.first < second.first;
+            });
+            return carets;
+        }
+    }
+
+    void TextBox::mergeCarets() {
+        if (additionalCarets.empty()) return;
+
+        std::vector<std::pair<Pos, Caret *>> carets = getSortedCarets(*this);
+        std::unordered_set<const Caret *> merged;
+        for (std::size_t i = 1; i < carets.size(); i++) {
+            if (carets[i].first != carets[i - 1].first) continue;
+            // keep the primary caret, which is the first of carets at the same position
+            merged.insert(carets[i].second == &caret ? carets[i - 1].second : carets[i].second);
+        }
+        if (merged.empty()) return;
+
+        additionalCarets.erase(std::remove_if(additionalCarets.begin(), additionalCarets.end(), [&merged](const auto &c) {
+            return merged.count(c.get()) != 0;
+        }), additionalCarets.end());
+        setRedrawRequired();
+    }
+
+    void TextBox::insertAtCarets(const sf::String &text) {
+        EditTimer timer(*this);
+        if (additionalCarets.empty()) {
+            caret.insert(text);
+            return;
+        }
+
+        std::vector<std::pair<Pos, Caret *>> carets;
+        std::vector<Pos> ends;
+        {
+            // the selections are removed and the text inserted as a single change
+            Document::EditScope scope(*document);
+            removeAtCarets();
+
+            // carets at the same position share one insertion
+            carets = getSortedCarets(*this);
+            std::vector<Pos> positions;
+            positions.reserve(carets.size());
+            for (const auto &c : carets) {
+                if (positions.empty() || positions.back() != c.first) positions.push_back(c.first);
+            }
+            ends = insertText(positions, text);
+        }
+        for (std::size_t i = 0, j = 0; i < carets.size(); i++) {
+            if (i > 0 && carets[i].first != carets[i - 1].first) j++;
+            carets[i].second->setPosition(ends[j]);
+        }
+        mergeCarets();
+
+        Pos position = caret.getPosition();
+        if (!isPositionOnScreen(position)) setScrollTo(position);
+    }
+
+    void TextBox::removeAtCarets(int characters) {
+        EditTimer timer(*this);
+        std::vector<std::pair<Pos, Pos>> ranges;
+        std::vector<Caret *> removing;
+        for (std::size_t i = 0; i < getNumberCarets(); i++) {
+            Caret &c = getCaret(i);
+            if (c.hasSelection()) ranges.emplace_back(c.getPosition(), c.getSelectionEndPos());
+            else if (characters != 0) ranges.emplace_back(c.getPosition(), getRelativeCharacters(c.getPosition(), characters));
+            else continue;
+            removing.push_back(&c);
+        }
+        if (ranges.empty()) return;
+
+        std::vector<Pos> starts = document->removeText(ranges);
+        // removed characters transfer their anchors to the preceding character, the carets are placed explicitly
+        for (std::size_t i = 0; i < removing.size(); i++) removing[i]->setPosition(starts[i]);
+        mergeCarets();
+    }
+
+    void TextBox::selectAllOccurrences() {
+        if (!caret.hasSelection()) return;
+        sf::String pattern = caret.getSelectedText();
+
+        std::vector<Pos> occurrences = findAll(pattern);
+        Pos selected = std::min(caret.getPosition(), caret.getSelectionEndPos());
+        removeAdditionalCarets();
+        for (const Pos &start : occurrences) {
+            // the primary caret keeps its own selection
+            if (start == selected) continue;
+            Caret &added = addCaret(start);
+            added.setSelectionEndPos(getEndOf(start, pattern));
+        }
+    }
+
+    std::pair<std::size_t, std::size_t> TextBox::getBlockSpan(std::size_t line) const {
+        assert(blockSelection && blockSelection->containsLine(line) && "line is not within the block selection");
+        std::size_t length = getLineLength(line);
+        return {std::min(length, getLinePositionAt(line, blockSelection->left, 0.5f)),
+                std::min(length, getLinePositionAt(line, blockSelection->right, 0.5f))};
+    }
+
+    sf::String TextBox::getBlockText() const {
+        if (!blockSelection) return "";
+
+        std::vector<std::pair<std::size_t, std::size_t>> spans;
+        spans.reserve(blockSelection->getNumberLines());
+        std::size_t size = blockSelection->getNumberLines() - 1;
+        for (std::size_t line = blockSelection->firstLine; line <= blockSelection->lastLine; line++) {
+            spans.push_back(getBlockSpan(line));
+            size += spans.back().second - spans.back().first;
+        }
+
+        std::basic_string<Char> str;
+        str.reserve(size);
+        for (std::size_t i = 0; i < spans.size(); i++) {
+            if (i > 0) str += '\n';
+            LineView view = getLineView(blockSelection->firstLine + i, spans[i].first, spans[i].second);
+            str.append(view.begin(), view.end());
+        }
+        return str;
+    }
+
+    void TextBox::replaceBlockText(const sf::String &text) {
+        if (!blockSelection) return;
+        EditTimer timer(*this);
+        setRedrawRequired();
+
+        std::vector<std::pair<Pos, Pos>> spans;
+        spans.reserve(blockSelection->getNumberLines());
+        for (std::size_t line = blockSelection->firstLine; line <= blockSelection->lastLine; line++) {
+            auto [start, end] = getBlockSpan(line);
+            spans.emplace_back(Pos{line, start}, Pos{line, end});
+        }
+        removeBlockSelection();
+
+        std::vector<Pos> ends;
+        {
+            // the spans are removed and the text inserted as a single change
+            Document::EditScope scope(*document);
+            ends = insertText(document->removeText(spans), text);
+        }
+        removeAdditionalCarets();
+        caret.setPosition(ends.front());
+        additionalCarets.reserve(ends.size() - 1);
+        for (std::size_t i = 1; i < ends.size(); i++) {
+            addCaret(ends[i]);
+        }
+    }
+
+    void TextBox::drawBlockSelection(sf::RenderTarget &target, sf::RenderStates states) const {
+        std::size_t first = std::max(blockSelection->firstLine, getVisibleStart().line);
+        std::size_t last = std::min(blockSelection->lastLine, getVisibleEnd().line);
+
+        sf::VertexArray vertices(sf::Triangles);
+        float lineHeight = getLineHeight();
+        for (std::size_t line = first; line <= last && line < getNumberLines(); line++) {
+            auto [start, end] = getBlockSpan(line);
+            if (start == end) continue;
+
+            sf::Vector2f topLeft = getOffsetOf({line, start});
+            sf::Vector2f bottomRight = getOffsetOf({line, end});
+            // with word wrap, the span may continue on the next row -- highlight up to the end of the first row
+            if (bottomRight.y != topLeft.y) bottomRight.x = getSize().x;
+            bottomRight.y = topLeft.y + lineHeight;
+
+            const sf::Color &color = CaretStyle::TEXT_HIGHLIGHT_COLOR;
+            vertices.append({topLeft, color});
+            vertices.append({{bottomRight.x, topLeft.y}, color});
+            vertices.append({bottomRight, color});
+            vertices.append({topLeft, color});
+            vertices.append({bottomRight, color});
+            vertices.append({{topLeft.x, bottomRight.y}, color});
+        }
+        target.draw(vertices, states);
+        detail::countDrawCall();
     }
 
     void TextBox::handleScroll(bool vertical, float amount) {
@@ -434,11 +920,28 @@ namespace sftb {
             return;
 
         if (button == sf::Mouse::Button::Left) {
-            if (pressed) {
+            if (pressed && altHeld) {
+                // alt drag selects a block
+                removeAdditionalCarets();
+                caret.removeSelection();
+                removeBlockSelection();
+                if (getNumberLines() > 0) {
+                    blockAnchorLine = std::min(getPositionAt(x, y).line, getNumberLines() - 1);
+                    blockAnchorX = static_cast<float>(x) - getTextOffsetHorizontal();
+                    blockSelectionActive = true;
+                }
+            } else if (pressed && controlHeld) {
+                // control click adds a caret
+                addCaret(caret.getClosestPos(getPositionAt(x, y, CHARACTER_ROUNDING)));
+                mergeCarets();
+            } else if (pressed) {
+                removeAdditionalCarets();
+                removeBlockSelection();
                 caret.setClosestPosition(getPositionAt(x, y, CHARACTER_ROUNDING));
                 selectionActive = true;
             } else {
                 selectionActive = false;
+                blockSelectionActive = false;
             }
         }
     }
@@ -447,93 +950,189 @@ namespace sftb {
         scrollBarManager.getVerticalScrollBar().getScrollBarStyle().handleMouseMove(sf::Vector2f(x, y), scrollBarManager.getVerticalScrollBar());
         scrollBarManager.getHorizontalScrollBar().getScrollBarStyle().handleMouseMove(sf::Vector2f(x, y), scrollBarManager.getHorizontalScrollBar());
 
+        // the document may have been emptied or shortened since the drag started
+        if (blockSelectionActive && getNumberLines() == 0) blockSelectionActive = false;
+        if (blockSelectionActive) {
+            std::size_t lastLine = getNumberLines() - 1;
+            std::size_t line = std::min(getPositionAt(x, y).line, lastLine);
+            setBlockSelection(BlockSelection::between(std::min(blockAnchorLine, lastLine), blockAnchorX, line,
+                                                      static_cast<float>(x) - getTextOffsetHorizontal()));
+        }
+
         if (selectionActive) {
             caret.setSelectionEndClosestPosition(getPositionAt(x, y, CHARACTER_ROUNDING));
         }
     }
 
-    std::size_t TextBox::getLongestLineLength() const {
-        assert(lines.size() == lineLength.size() && "lineLength and lines have different number of elements");
-        return lineLength.empty() ? 0 : (***lineLength.begin()).getNumberCharacters();
+    float TextBox::getLongestLineWidth() const {
+        // lineLength is ordered by number of characters; for non-monospaced fonts the line with the most characters is
+        // not necessarily the widest, so the widest line drawn is also taken into account, rather than laying out every
+        // line
+        const Line *longest = document->getLongestLine();
+        return std::max(longest == nullptr ? 0 : longest->getWidth(*this), widestLineWidth);
+    }
+
+    const std::vector<std::size_t> &TextBox::getWrapPositions(std::size_t lineIndex) const {
+        assert(lineWraps.size() == getNumberLines() && "word wrap is not enabled");
+        LineWrap &wrap = lineWraps[lineIndex];
+        if (wrap.generation == wrapGeneration) return wrap.positions;
+
+        const Line &line = getLine(lineIndex);
+        line.layoutUntil(*this, line.getNumberCharacters());
+        const std::vector<float> &offsets = line.getAdvanceOffsets();
+        const Char *text = line.getText();
+        float width = getWrapWidth();
+        wrap.positions.clear();
+        wrap.generation = wrapGeneration;
+
+        std::size_t start = 0, breakPosition = 0;
+        for (std::size_t i = 0; i < line.getNumberCharacters(); i++) {
+            Char c = text[i];
+            if (c == ' ' || c == '\t') {
+                // whitespace may extend past the wrap width, lines are broken after it
+                breakPosition = i + 1;
+                continue;
+            }
+
+            while (i > start && offsets[i + 1] - offsets[start] > width) {
+                // break after the last whitespace, or before this character if the word doesn't fit on one line
+                start = breakPosition > start ? breakPosition : i;
+                wrap.positions.push_back(start);
+            }
+        }
+
+        updateVisualLines(lineIndex, wrap.positions.size() + 1);
+        return wrap.positions;
+    }
+
+    std::size_t TextBox::getVisualLineWithin(std::size_t line, std::size_t position) const {
+        const std::vector<std::size_t> &positions = getWrapPositions(line);
+        return std::upper_bound(positions.begin(), positions.end(), position) - positions.begin();
+    }
+
+    std::size_t TextBox::getVisualLineStart(std::size_t line, std::size_t visualLine) const {
+        return visualLine == 0 ? 0 : getWrapPositions(line)[visualLine - 1];
     }
 
-    std::size_t TextBox::getLineIndex(const Line *line) const {
-        assert(line != nullptr && "line is nullptr");
-        // same logic as CharInfo getCharacterIndex
-        return line - &*lines.begin();
+    std::size_t TextBox::getVisualLineEnd(std::size_t line, std::size_t visualLine) const {
+        const std::vector<std::size_t> &positions = getWrapPositions(line);
+        return visualLine < positions.size() ? positions[visualLine] : getLineLength(line);
     }
 
-    detail::Line &TextBox::getOrInsertLine(std::size_t line) {
-        assert(line <= getNumberLines() && "line out of bounds");
-        return getNumberLines() == line ? *lines.emplace(lines.begin() + line, this) : lines[line];
+    std::size_t TextBox::estimateVisualLines(std::size_t line) const {
+        float width = static_cast<float>(getLineLength(line)) * getCharacterWidth();
+        return std::max<std::size_t>(1, static_cast<std::size_t>(std::ceil(width / getWrapWidth())));
     }
 
     namespace detail {
-        void Line::remove(std::size_t start, std::size_t end) {
-            auto endIndex = std::min(end, getNumberCharacters());
-
-            CharPos transferPos;
-
-            if (start == 0) {
-                auto lineIndex = getTextBox().getLineIndex(this);
-                if (lineIndex == 0) {
-                    // end character if exists, or end of line
-                    transferPos = getTextBox().getCharPos({lineIndex, endIndex});
-                } else {
-                    Line &previousLine = getTextBox().getLine(lineIndex - 1);
-                    transferPos = previousLine.endLineCharPosDataHolder.getCharPos(&previousLine, nullptr);
-                }
-            } else {
-                CharInfo &info = characters[start - 1];
-                transferPos = info.referenceHolder.getCharPos(this, &info);
+        void Line::useLayout(unsigned id) const {
+            auto kept = std::find_if(otherLayouts.begin(), otherLayouts.end(), [id](const auto &layout) {
+                return layout.first == id;
+            });
+            if (kept == otherLayouts.end()) {
+                if (otherLayouts.size() < LINE_LAYOUTS - 1) kept = otherLayouts.emplace(otherLayouts.end());
+                else kept = otherLayouts.end() - 1;
+                kept->first = id;
+                kept->second.clear();
             }
 
-            auto iterStart = characters.begin() + start;
-            auto iterEnd = characters.begin() + endIndex;
-            prepareRemove(transferPos, iterStart, iterEnd);
-
-            characters.erase(iterStart, iterEnd);
-            updateLineLength();
+            // the current offsets take the place of those of id, and become the most recently used
+            std::swap(kept->first, layoutId);
+            std::swap(kept->second, advanceOffsets);
+            std::rotate(otherLayouts.begin(), kept, kept + 1);
+            if (otherLayouts.front().first == 0) otherLayouts.erase(otherLayouts.begin());
         }
 
-        void Line::move(Line &line, std::size_t start, std::size_t insertPosition) {
-            assert(start <= getNumberCharacters() && "start out of bounds");
-            assert(insertPosition <= line.getNumberCharacters() && "insert position out of bounds");
-            // todo - clean up
+        void Line::layoutUntil(const TextBox &view, std::size_t position) const {
+            if (layoutId != view.layoutId) useLayout(view.layoutId);
+
+            std::size_t index = advanceOffsets.size();
+            if (index > position || isLaidOut()) return;
+
+            // lay out whole chunks, up to and including the chunk containing position
+            std::size_t end = std::min((position / LAYOUT_CHUNK + 1) * LAYOUT_CHUNK, getNumberCharacters());
+            const GlyphMetrics &metrics = view.getGlyphMetrics();
+            float tabWidth = view.getTabWidth();
+            const Char *lineText = getText();
+
+            // resume after the last character laid out
+            float x = 0;
+            Char previous = 0;
+            if (index > 0) {
+                previous = lineText[index - 1];
+                x = advanceOffsets[index - 1];
+                if (previous == '\t') {
+                    x = (std::floor(x / tabWidth) + 1) * tabWidth;
+                    previous = 0;
+                } else x += metrics.getAdvance(previous);
+            }
+
+            // same layout as sf::Text -- kerning is applied before each character
+            // except for tabs, which advance to the next tab stop
+            for (; index < end; index++) {
+                Char c = lineText[index];
+                if (c == '\t') {
+                    advanceOffsets.push_back(x);
+                    x = (std::floor(x / tabWidth) + 1) * tabWidth;
+                    previous = 0;
+                    continue;
+                }
+
+                x += metrics.getKerning(previous, c);
+                advanceOffsets.push_back(x);
+                x += metrics.getAdvance(c);
+                previous = c;
+            }
 
-            // move characters (at and after start) to other line at insertPosition
-            auto iterFirstCharacter = characters.begin() + start;
-            auto iterLastCharacter = characters.end();
+            // width of the line
+            if (end == getNumberCharacters()) advanceOffsets.push_back(x);
+        }
 
-            // update character line
-            auto iter = iterFirstCharacter;
-            while (iter < characters.end()) {
-                iter->referenceHolder.updateLine(line);
-                iter++;
+        float Line::getWidth(const TextBox &view) const {
+            if (layoutId != view.layoutId) useLayout(view.layoutId);
+            if (getNumberCharacters() >= view.getLongLineLength() && !isLaidOut()) {
+                // long line mode: estimate the remainder of the line instead of laying it out
+                float characterWidth = view.getCharacterWidth();
+                if (advanceOffsets.empty())
+                    return static_cast<float>(getNumberCharacters()) * characterWidth;
+                return advanceOffsets.back() + static_cast<float>(getNumberCharacters() - advanceOffsets.size() + 1) * characterWidth;
             }
 
-            line.characters.insert(line.characters.begin() + insertPosition,
-                                   std::make_move_iterator(iterFirstCharacter),
-                                   std::make_move_iterator(iterLastCharacter));
-            characters.erase(iterFirstCharacter, iterLastCharacter);
-            line.updateLineLength();
-            updateLineLength();
+            layoutUntil(view, getNumberCharacters());
+            return advanceOffsets.back();
         }
 
-        void Line::insert(const sf::String &string, std::size_t index) {
-            assert(index <= getNumberCharacters() && "index out of bounds");
-            for (char c : string) {
-                // todo - optimize (will push characters back multiple times)
-                characters.emplace(characters.begin() + index++, c);
+        float Line::getOffset(const TextBox &view, std::size_t position) const {
+            if (position < getNumberCharacters()) {
+                layoutUntil(view, position);
+                return advanceOffsets[position];
             }
-            updateLineLength();
+
+            layoutUntil(view, getNumberCharacters());
+            // past the end of the line
+            return advanceOffsets.back() + static_cast<float>(position - getNumberCharacters()) * view.getCharacterWidth();
         }
 
-        void Line::prepareRemove(const CharPos &transferPos, const std::vector<CharInfo>::iterator &start,
-                                 const std::vector<CharInfo>::iterator &end) {
-            for (auto iter = start; iter < end; iter++) {
-                iter->referenceHolder.transfer(transferPos);
+        std::size_t Line::getPositionAt(const TextBox &view, float offset, float round) const {
+            if (offset <= 0) return 0;
+
+            // lay out one chunk at a time until offset is reached
+            layoutUntil(view, 0);
+            while (!isLaidOut() && (advanceOffsets.empty() || advanceOffsets.back() <= offset)) {
+                layoutUntil(view, advanceOffsets.size());
             }
+
+            const std::vector<float> &offsets = advanceOffsets;
+            if (isLaidOut() && offset >= offsets.back()) {
+                // past the end of the line
+                return getNumberCharacters() + static_cast<std::size_t>((offset - offsets.back()) / view.getCharacterWidth() + round);
+            }
+
+            // offsets[position] <= offset < offsets[position + 1]
+            std::size_t position = std::upper_bound(offsets.begin(), offsets.end(), offset) - offsets.begin() - 1;
+            float advance = offsets[position + 1] - offsets[position];
+            if (offset - offsets[position] >= (1 - round) * advance) position++;
+            return position;
         }
     }
-}
\ No newline at end of file
+}
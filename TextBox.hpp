@@ -5,14 +5,20 @@
 #include <SFML/Window/Mouse.hpp>
 #include <SFML/System/String.hpp>
 #include <SFML/System/Clock.hpp>
+#include <array>
+#include <chrono>
 #include <utility>
 #include <variant>
 #include <vector>
+#include <deque>
 #include <set>
 #include <memory>
 #include <list>
+#include <optional>
+#include <string>
+#include <algorithm>
 #include <cassert>
-#include "CharPos.hpp"
+#include "Document.hpp"
 #include "InputHandler.hpp"
 #include "ScrollBar.hpp"
 #include "Reference.hpp"
@@ -20,6 +26,16 @@
 #include "Pos.hpp"
 #include "Caret.hpp"
 #include "Highlight.hpp"
+#include "GlyphMetrics.hpp"
+#include "FenwickTree.hpp"
+#include "BlockSelection.hpp"
+#include "Stats.hpp"
+#include "LatencyHistogram.hpp"
+#include "EventRecording.hpp"
+#include "AppendQueue.hpp"
+#include "FileLoader.hpp"
+#include "DocumentSaver.hpp"
+#include "FileFollower.hpp"
 
 namespace sf {
     class Font;
@@ -27,100 +43,226 @@ namespace sf {
 }
 
 namespace sftb {
-    namespace detail {
-        class CharPosDataHolder {
-        private:
-            std::weak_ptr<CharPosData> reference;
+    class TextBox : public sf::Drawable, public Reference<TextBox> {
+        friend class detail::Line;
+        friend class Highlight;
+    private:
+        using Line = detail::Line;
 
+        // forwards the changes of the document to its TextBox. Allocated separately, so the listener registered with
+        // the document stays valid when the TextBox is moved
+        class DocumentObserver : public DocumentListener {
+        private:
+            TextBox **box;
+            std::shared_ptr<Document> document;
         public:
-            CharPosDataHolder() = default;
-            CharPosDataHolder(const CharPosDataHolder &) = delete;
-            CharPosDataHolder &operator=(const CharPosDataHolder &) = delete;
-            CharPosDataHolder(CharPosDataHolder &&) = default;
-            CharPosDataHolder &operator=(CharPosDataHolder &&) = default;
-
-            ~CharPosDataHolder() {
-                assert(!active() && "CharPosDataHolder info was not transferred");
+            DocumentObserver(TextBox **box, std::shared_ptr<Document> document) : box(box), document(std::move(document)) {
+                this->document->addListener(this);
             }
 
-            void transfer(const CharPos &pos);
+            DocumentObserver(const DocumentObserver &) = delete;
+            DocumentObserver &operator=(const DocumentObserver &) = delete;
 
-            [[nodiscard]] bool active() const {
-                return !reference.expired();
+            ~DocumentObserver() override {
+                document->removeListener(this);
             }
 
-            void updateLine(Line &line);
-            void updateCharInfo(CharInfo *info);
-            CharPos getCharPos(Line *line, CharInfo *info);
+            void onDocumentChange(const DocumentChange &change) override {
+                (**box).handleDocumentChange(change);
+            }
         };
 
-        class Line;
-    }
-
-    class TextBox : public sf::Drawable, public Reference<TextBox> {
-        friend class detail::Line;
-        friend class Highlight;
-    private:
-        using Line = detail::Line;
-        using CharPosDataHolder = detail::CharPosDataHolder;
-        using CharPosData = detail::CharPosData;
-        using CharInfo = detail::CharInfo;
-
-        struct LineLengthCompare {
-            bool operator()(Line **left, Line **right) const;
+        // word wrap of a line of the document, see getWrapPositions()
+        struct LineWrap {
+            // start of each visual line after the first
+            std::vector<std::size_t> positions;
+            // wrapGeneration the line was wrapped with, 0 if it changed since
+            unsigned generation = 0;
+            // number of visual lines of the line currently stored in visualLines
+            std::size_t indexedVisualLines = 1;
         };
 
-        using LineLengthSet = std::multiset<Line **, LineLengthCompare>;
-
-        LineLengthSet lineLength;
-        std::vector<Line> lines;
+        std::shared_ptr<Document> document;
         sf::Font *font;
+        // see GlyphMetrics::use()
+        std::shared_ptr<const void> fontUse;
         std::size_t characterSize;
-        float lineHeight, characterWidth;
+        std::shared_ptr<const GlyphMetrics> metrics;
+        // Document::getLayoutId() of metrics and tabSize, changes whenever the font, character size or tab size change;
+        // lines laid out with another layout are laid out again when next used
+        unsigned layoutId;
+        // width of a tab, in spaces
+        unsigned tabSize = 4;
+        std::size_t longLineLength = DEFAULT_LONG_LINE_LENGTH;
+        bool wordWrap = false;
+        // one per line of the document while word wrap is enabled, empty otherwise
+        mutable std::deque<LineWrap> lineWraps;
+        // incremented whenever lines need to be wrapped again (wrap width or layout changed)
+        // 0 is reserved for lines whose contents changed
+        unsigned wrapGeneration = 1;
+        // number of visual lines of each line -- exact for lines which have been wrapped since the last wrapGeneration
+        // change, estimated for the rest. Rebuilt (without wrapping) when lines are inserted or removed
+        mutable detail::FenwickTree<std::size_t> visualLines;
+        mutable bool visualLinesValid = false;
+        // next line to be wrapped in the background, see draw()
+        mutable std::size_t wrapFillLine = 0;
+        // the widest line drawn, and its width (0 once the line changed), see getLongestLineWidth()
+        mutable std::size_t widestLine = 0;
+        mutable float widestLineWidth = 0;
         sf::Vector2f offset, size;
         mutable std::shared_ptr<bool> redraw;
         ScrollBarManager scrollBarManager;
+        // see setFollow(), followPinned is whether the end of the document was visible before the latest change
+        bool follow = false;
+        bool followPinned = true;
         sf::Color backgroundColor = sf::Color::Black;
         std::shared_ptr<InputHandler> inputHandler = InputHandler::standard();
         bool selectionActive = false;
-        CharPosDataHolder endCharPosDataHolder;
+        // modifiers held as of the last key input, used by mouse input so that replayed events behave the same
+        bool controlHeld = false;
+        bool altHeld = false;
+        std::optional<BlockSelection> blockSelection;
+        // corner of the block selection where dragging started, see handleInput()
+        bool blockSelectionActive = false;
+        std::size_t blockAnchorLine = 0;
+        float blockAnchorX = 0;
         std::shared_ptr<CaretStyle> caretStyle = std::make_shared<StandardCaretStyle>();
         Caret caret;
+        // carets other than the primary caret, see addCaret()
+        std::vector<std::unique_ptr<Caret>> additionalCarets;
         std::list<std::shared_ptr<Highlight>> highlights;
 
-        Line &getLine(std::size_t line) {
-            assert(line < getNumberLines() && "line out of bounds");
-            return lines[line];
+        // text being pasted over several frames, see paste()
+        struct PendingPaste {
+            sf::String text;
+            std::size_t inserted = 0;
+            // last character inserted so far, the next slice is inserted after it
+            CharPos last;
+        };
+        std::optional<PendingPaste> pendingPaste;
+        sf::Time pasteTimeBudget = sf::milliseconds(4);
+
+        // time from handleEvent() until the end of the following draw(), per InputEventType
+        mutable std::array<LatencyHistogram, INPUT_EVENT_TYPES> latencyHistograms;
+        // events handled since the last draw(), with the time they were received
+        mutable std::vector<std::pair<InputEventType, std::chrono::steady_clock::time_point>> pendingLatencies;
+        std::shared_ptr<EventRecorder> eventRecorder;
+        std::shared_ptr<AppendQueue> appendQueue;
+        // file being loaded, see loadFile()
+        std::shared_ptr<FileLoader> fileLoader;
+        // file being followed, see followFile()
+        std::shared_ptr<FileFollower> fileFollower;
+        sf::Time loadTimeBudget = sf::milliseconds(4);
+
+        mutable FrameInfo lastFrame;
+        mutable std::chrono::steady_clock::time_point lastDrawStart;
+        sf::Time lastEditTime;
+        // number of edits in progress, edits made by other edits are measured as part of the outermost edit
+        unsigned editDepth = 0;
+
+        // last, so the previous document outlives the carets and highlights anchored in it when a TextBox is assigned
+        std::unique_ptr<DocumentObserver> documentObserver;
+
+        // measures the duration of an edit, see getLastEditTime()
+        class EditTimer {
+        private:
+            TextBox &box;
+            std::chrono::steady_clock::time_point start;
+        public:
+            explicit EditTimer(TextBox &box) : box(box), start(std::chrono::steady_clock::now()) {
+                box.editDepth++;
+            }
+
+            EditTimer(const EditTimer &) = delete;
+            EditTimer &operator=(const EditTimer &) = delete;
+
+            ~EditTimer() {
+                if (--box.editDepth == 0) box.lastEditTime = toTime(std::chrono::steady_clock::now() - start);
+            }
+        };
+
+        static sf::Time toTime(std::chrono::steady_clock::duration duration) {
+            return sf::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
         }
 
         const Line &getLine(std::size_t line) const {
-            return const_cast<TextBox *>(this)->getLine(line);
+            return document->getLine(line);
         }
 
-        Line &getOrInsertLine(std::size_t line);
-
-        [[nodiscard]] std::size_t getLineIndex(const Line *line) const;
+        // keeps the state of this view of the document (such as word wrap) in step with its edits
+        void handleDocumentChange(const DocumentChange &change);
 
         [[nodiscard]] float getCharacterWidth() const {
-            // todo support non monospaced fonts
-            return characterWidth;
+            // nominal character width, used for positions past the end of a line
+            // characters within a line are laid out using their actual advance (see Line::layoutUntil)
+            return metrics->getAdvance('a');
+        }
+
+        void updateGlyphMetrics();
+        void invalidateLayout();
+
+        [[nodiscard]] float getLongestLineWidth() const;
+
+        // horizontal offset of position relative to the start of its line (not including scrolling)
+        [[nodiscard]] float getLineOffset(const Pos &pos) const;
+        // position within line closest to xOffset (relative to the start of the line)
+        [[nodiscard]] std::size_t getLinePositionAt(std::size_t line, float xOffset, float roundX = 0) const;
+
+        struct VisualLine {
+            std::size_t line, start, end;
+        };
+
+        [[nodiscard]] float getWrapWidth() const;
+        void invalidateWrap();
+        void invalidateVisualLines() const {
+            visualLinesValid = false;
+        }
+        void ensureVisualLines() const;
+        // called after line has been wrapped
+        void updateVisualLines(std::size_t line, std::size_t rows) const;
+        // start of each visual line of line after the first, line is wrapped if it changed since it was last wrapped
+        // only valid with word wrap enabled
+        const std::vector<std::size_t> &getWrapPositions(std::size_t line) const;
+
+        [[nodiscard]] std::size_t getNumberVisualLines(std::size_t line) const {
+            return getWrapPositions(line).size() + 1;
         }
 
-        [[nodiscard]] std::size_t getLongestLineLength() const;
+        // visual line of position, counted from the first visual line of line
+        [[nodiscard]] std::size_t getVisualLineWithin(std::size_t line, std::size_t position) const;
+        [[nodiscard]] std::size_t getVisualLineStart(std::size_t line, std::size_t visualLine) const;
+        [[nodiscard]] std::size_t getVisualLineEnd(std::size_t line, std::size_t visualLine) const;
+        // number of visual lines of line without wrapping it, based on the nominal character width
+        [[nodiscard]] std::size_t estimateVisualLines(std::size_t line) const;
+        [[nodiscard]] VisualLine getVisualLine(std::size_t visualLine) const;
+        [[nodiscard]] Pos getPositionInVisualLine(std::size_t visualLine, float xOffset, float roundX) const;
 
         // return true if verify is true, and either x or y are outside this TextBox
         bool isOutBounds(bool verify, int x, int y) const;
+        // passes event to its handler, returns the type of the event or nothing if it was ignored
+        std::optional<InputEventType> dispatchEvent(const sf::Event &event, bool verifyArea);
 
-        CharPos getTransferPos(std::size_t start, std::size_t end) {
-            return start == 0 ? getCharPos({end, getLineLength(end)}) :
-                   getCharPos({start - 1, getLineLength(start - 1)});
-        }
+        void drawText(sf::RenderTarget &target, sf::RenderStates states) const;
+        // a single batch of rectangles, covering only the visible lines
+        void drawBlockSelection(sf::RenderTarget &target, sf::RenderStates states) const;
+
+        // called at the end of draw(), records the latency of each pending event
+        void recordLatencies() const;
+
+        // inserts the next slice of pendingPaste, finishing the paste after the last one
+        void continuePaste();
 
     protected:
         void draw(sf::RenderTarget &target, sf::RenderStates states) const override;
     public:
+        static constexpr std::size_t DEFAULT_LONG_LINE_LENGTH = 10000;
+
         explicit TextBox(sf::Font &font, sf::Vector2f size, std::size_t characterSize = 16,
                          std::shared_ptr<bool> redraw = nullptr);
+        // a view of document, which may be shared with other TextBoxes. Each TextBox has its own scrolling, carets,
+        // highlights and font, edits made through any of them are shown by all of them
+        TextBox(std::shared_ptr<Document> document, sf::Font &font, sf::Vector2f size, std::size_t characterSize = 16,
+                std::shared_ptr<bool> redraw = nullptr);
 
         // it may make sense to allow explicit copy operations, but unnecessary for now
         TextBox(const TextBox &) = delete;
@@ -144,51 +286,78 @@ namespace sftb {
         }
 
         void setSize(const sf::Vector2f &s) {
+            bool widthChanged = size.x != s.x;
             size = s;
+            if (wordWrap && widthChanged) invalidateWrap();
             setRedrawRequired();
         }
 
+        [[nodiscard]] bool isWordWrap() const {
+            return wordWrap;
+        }
+
+        // wrap lines wider than this TextBox at word boundaries
+        void setWordWrap(bool wrap) {
+            if (wordWrap == wrap) return;
+            wordWrap = wrap;
+            if (wrap) lineWraps.resize(getNumberLines());
+            else std::deque<LineWrap>().swap(lineWraps);
+            invalidateWrap();
+        }
+
+        [[nodiscard]] bool isFollow() const {
+            return follow;
+        }
+
+        // while following, the view stays at the end of the document as text is added (such as a log tail), as long as
+        // the end of the document is visible. Scrolling away from the end keeps the view on the same text, scrolling
+        // back to the end follows it again
+        void setFollow(bool f);
+
+        // number of lines on screen, including additional lines created by word wrap
+        [[nodiscard]] std::size_t getNumberVisualLines() const;
+        [[nodiscard]] std::size_t getVisualLineOf(const Pos &pos) const;
+
         [[nodiscard]] float getLineHeight() const {
-            return lineHeight;
+            return metrics->getLineSpacing();
         }
 
         // 0.0 for no rounding
         // 0.5f for rounding at halfway
         // 0.3f for rounding at 0.7f
         // etc.
-        [[nodiscard]] Pos getPositionAt(float xOffset, float yOffset, float roundX = 0, float roundY = 0) const {
-            xOffset -= getTextOffsetHorizontal();
-            yOffset -= getTextOffsetVertical();
-
-            // when non-monospaced fonts are provided this operation may become somewhat more expensive
-            // although the != 0 checks are largely pointless now, they may be worthwhile later
-            if (roundX != 0) xOffset += roundX * getCharacterWidth();
-            if (roundY != 0) yOffset += roundY * getLineHeight();
-
-            return {static_cast<std::size_t>(std::max(0, static_cast<int>(yOffset / getLineHeight()))),
-                    static_cast<std::size_t>(std::max(0, static_cast<int>(xOffset / getCharacterWidth())))};
-        }
+        [[nodiscard]] Pos getPositionAt(float xOffset, float yOffset, float roundX = 0, float roundY = 0) const;
 
         [[nodiscard]] Pos getPositionAt(const sf::Vector2f &vector, float roundX, float roundY) const {
             return getPositionAt(vector.x, vector.y, roundX, roundY);
         }
 
-        [[nodiscard]] sf::Vector2f getOffsetOf(const Pos &pos) const {
-            return {
-                    getTextOffsetHorizontal() + static_cast<float>(pos.position) * getCharacterWidth(),
-                    getTextOffsetVertical() + static_cast<float>(pos.line) * getLineHeight()
-            };
-        }
+        [[nodiscard]] sf::Vector2f getOffsetOf(const Pos &pos) const;
 
         [[nodiscard]] sf::Vector2f getContentSize() const;
         [[nodiscard]] Pos getVisibleStart() const;
         [[nodiscard]] Pos getVisibleEnd() const;
         [[nodiscard]] bool isPositionOnScreen(const Pos &position) const;
-        [[nodiscard]] Pos getRelativeCharacters(Pos pos, int characters) const;
-        [[nodiscard]] Pos getRelativeLine(Pos pos, int lineAmount) const;
+        [[nodiscard]] Pos getRelativeCharacters(Pos pos, int characters) const {
+            return document->getRelativeCharacters(pos, characters);
+        }
+
+        [[nodiscard]] std::size_t posToOffset(Pos pos) const {
+            return document->posToOffset(pos);
+        }
+
+        [[nodiscard]] Pos offsetToPos(std::size_t offset) const {
+            return document->offsetToPos(offset);
+        }
+
+        [[nodiscard]] Pos getRelativeLine(Pos pos, int lineAmount) const {
+            return document->getRelativeLine(pos, lineAmount);
+        }
+
         // returns position above pos on screen (for monospaced fonts, this should return the same as getRelativeLine())
         [[nodiscard]] Pos getVisibleRelativeLine(Pos pos, int lineAmount) const;
 
+        // scrolls as little as needed for position to be visible
         void setScrollTo(const Pos &position);
 
         [[nodiscard]] sf::Font &getFont() const {
@@ -197,7 +366,9 @@ namespace sftb {
 
         void setFont(sf::Font &f) {
             font = &f;
-            setRedrawRequired();
+            // the previous font is released if this was its last TextBox
+            fontUse = GlyphMetrics::use(f);
+            updateGlyphMetrics();
         }
 
         [[nodiscard]] std::size_t getCharacterSize() const {
@@ -206,6 +377,38 @@ namespace sftb {
 
         void setCharacterSize(std::size_t s) {
             characterSize = s;
+            updateGlyphMetrics();
+        }
+
+        [[nodiscard]] const GlyphMetrics &getGlyphMetrics() const {
+            return *metrics;
+        }
+
+        [[nodiscard]] unsigned getTabSize() const {
+            return tabSize;
+        }
+
+        // tabs advance to the next multiple of tabSize spaces
+        void setTabSize(unsigned size) {
+            assert(size > 0 && "tab size must be positive");
+            tabSize = size;
+            invalidateLayout();
+        }
+
+        [[nodiscard]] float getTabWidth() const {
+            return static_cast<float>(tabSize) * metrics->getAdvance(' ');
+        }
+
+        [[nodiscard]] std::size_t getLongLineLength() const {
+            return longLineLength;
+        }
+
+        // lines with at least this many characters are only laid out as far as they are displayed or navigated,
+        // their width (used for horizontal scrolling) is estimated beyond that point. Layout starts at the start of the
+        // line, so scrolling far right on such a line, or editing its start while scrolled right, lays out every
+        // character up to the visible columns once
+        void setLongLineLength(std::size_t length) {
+            longLineLength = length;
             setRedrawRequired();
         }
 
@@ -266,35 +469,74 @@ namespace sftb {
             }
         }
 
+        [[nodiscard]] const std::shared_ptr<Document> &getDocument() const {
+            return document;
+        }
+
+        // the text functions below are those of getDocument(), see Document
         [[nodiscard]] std::size_t getNumberLines() const {
-            return lines.size();
+            return document->getNumberLines();
         }
 
-        [[nodiscard]] std::size_t getLineLength(std::size_t line) const;
+        [[nodiscard]] std::size_t getLineLength(std::size_t line) const {
+            return document->getLineLength(line);
+        }
 
         [[nodiscard]] Pos getStartPos() const {
-            // included to make code more readable
-            return {0, 0};
+            return document->getStartPos();
         }
 
         [[nodiscard]] Pos getEndPos() const {
-            return {getNumberLines(), 0};
+            return document->getEndPos();
         }
 
-        CharPos getCharPos(const Pos &pos);
+        CharPos getCharPos(const Pos &pos) {
+            return document->getCharPos(pos);
+        }
 
         [[nodiscard]] Pos getPositionOfChar(const CharPos &pos) const {
-            assert(pos && "empty CharPos");
-            const CharPosData::Absolute &absolute = pos->getLinkedAbsolute();
-            return absolute.line == nullptr ? getEndPos() : Pos{getLineIndex(*absolute.line), pos->getCharacterIndex()};
+            return document->getPositionOfChar(pos);
+        }
+
+        [[nodiscard]] sf::String getTextFrom(Pos first, Pos second) const {
+            return document->getTextFrom(first, second);
         }
 
-        [[nodiscard]] sf::String getTextFrom(Pos first, Pos second) const;
-        [[nodiscard]] sf::String getLineContents(std::size_t line, std::size_t start = 0, std::size_t end = -1) const;
+        [[nodiscard]] sf::String getLineContents(std::size_t line, std::size_t start = 0, std::size_t end = -1) const {
+            return document->getLineContents(line, start, end);
+        }
+
+        [[nodiscard]] LineView getLineView(std::size_t line, std::size_t start = 0, std::size_t end = -1) const {
+            return document->getLineView(line, start, end);
+        }
+
+        [[nodiscard]] std::size_t getTextSize(Pos first, Pos second) const {
+            return document->getTextSize(first, second);
+        }
+
+        template<typename OutputIt>
+        OutputIt copyText(Pos first, Pos second, OutputIt out) const {
+            return document->copyText(first, second, out);
+        }
+
+        [[nodiscard]] std::size_t getTextSizeUtf8(Pos first, Pos second) const {
+            return document->getTextSizeUtf8(first, second);
+        }
+
+        template<typename OutputIt>
+        OutputIt copyTextUtf8(Pos first, Pos second, OutputIt out) const {
+            return document->copyTextUtf8(first, second, out);
+        }
+
+        [[nodiscard]] std::string getTextUtf8(Pos first, Pos second) const {
+            return document->getTextUtf8(first, second);
+        }
 
         Pos insertText(Pos pos, const sf::String &text);
+        std::vector<Pos> insertText(const std::vector<Pos> &positions, const sf::String &text);
         Pos insertLine(unsigned line, const sf::String &string = "");
         void removeText(Pos from, Pos to);
+        std::vector<Pos> removeText(const std::vector<std::pair<Pos, Pos>> &ranges);
 
         Pos replaceText(const Pos &from, const Pos &to, const sf::String &text) {
             removeText(from, to);
@@ -304,152 +546,204 @@ namespace sftb {
         void removeLine(unsigned line);
         void removeLines(unsigned start, unsigned end);
 
-        void handleEvent(const sf::Event &event, bool verifyArea = true);
-        void handleInput(sf::Keyboard::Key key, bool pressed, bool control, bool shift, bool alt);
-        void handleTextInput(const sf::String &string);
-        void handleScroll(bool vertical, float amount);
-        void handleInput(sf::Mouse::Button button, bool pressed, int x, int y);
-        void handleMousePositionChange(int x, int y);
+        // see Document::append(), lines removed from the start of the document do not move the visible text
+        Pos append(const sf::String &text);
 
-        [[nodiscard]] Caret &getPrimaryCaret() {
-            return caret;
+        // see Document::reloadText(), carets, highlights and the scroll position are kept around unchanged lines
+        void reloadText(const sf::String &content);
+
+        [[nodiscard]] std::vector<Pos> findAll(const sf::String &pattern) const {
+            return document->findAll(pattern);
         }
 
-        [[nodiscard]] const Caret &getPrimaryCaret() const {
-            return caret;
+        [[nodiscard]] static Pos getEndOf(const Pos &start, const sf::String &pattern) {
+            return Document::getEndOf(start, pattern);
         }
 
-        std::shared_ptr<Highlight> highlight(const Pos &first, const Pos &second, std::shared_ptr<Highlighter> highlighter);
+        // replaces the selection of the primary caret with text. Large texts are inserted a slice at a time by update(),
+        // the caret stays before the text and is moved to the end of it once all of it has been inserted
+        void paste(sf::String text);
+        // inserts the remainder of a paste in progress immediately
+        void finishPaste();
 
-        HighlightHandle handledHighlight(const Pos &first, const Pos &second, std::shared_ptr<Highlighter> highlighter) {
-            return HighlightHandle(highlight(first, second, std::move(highlighter)));
+        [[nodiscard]] bool isPasting() const {
+            return pendingPaste.has_value();
         }
 
-        void removeHighlight(const std::shared_ptr<Highlight> &highlight);
-    };
+        // fraction of the paste in progress which has been inserted, 1 if there is none
+        [[nodiscard]] float getPasteProgress() const;
 
-    namespace detail {
-        class CharInfo {
-            friend class sftb::TextBox;
-            friend class detail::Line;
-        private:
-            Char c;
-            // todo - can this be optimized out? characters are likely to be accessed sequentially, having them more tightly packed
-            //  could improve performance (in addition to being more memory friendly!)
-            CharPosDataHolder referenceHolder;
-        public:
-            explicit CharInfo(Char c) : c(c) {}
+        [[nodiscard]] sf::Time getPasteTimeBudget() const {
+            return pasteTimeBudget;
+        }
 
-            // while copying could be implemented, there is currently no intended
-            // reason to copy CharInfo. Operators are deleted for safety.
-            CharInfo(const CharInfo &) = delete;
-            CharInfo &operator=(const CharInfo &) = delete;
+        // maximum time spent pasting per update()
+        void setPasteTimeBudget(sf::Time budget) {
+            pasteTimeBudget = budget;
+        }
 
-            CharInfo(CharInfo &&other) noexcept: c(other.c), referenceHolder(std::move(other.referenceHolder)) {
-                referenceHolder.updateCharInfo(this);
-            }
+        // replaces the text of the document with the file at path, which is read on a background thread and appended
+        // by update() as it is read (see FileLoader). A load in progress is cancelled
+        std::shared_ptr<FileLoader> loadFile(const std::string &path);
 
-            CharInfo &operator=(CharInfo &&other) noexcept {
-                c = other.c;
-                referenceHolder = std::move(other.referenceHolder);
-                referenceHolder.updateCharInfo(this);
+        // writes the text of the document, as it is now, to path on a background thread while editing continues
+        std::shared_ptr<DocumentSaver> saveFile(const std::string &path, LineEnding lineEnding = LineEnding::LF) const {
+            return std::make_shared<DocumentSaver>(document->getSnapshot(), path, lineEnding);
+        }
 
-                return *this;
-            }
+        // the load in progress, nullptr once all of its text has been appended
+        [[nodiscard]] const std::shared_ptr<FileLoader> &getFileLoader() const {
+            return fileLoader;
+        }
 
-            [[nodiscard]] Char getChar() const {
-                return c;
-            }
-        };
+        [[nodiscard]] bool isLoading() const {
+            return fileLoader != nullptr;
+        }
 
-        class Line : public Reference<Line> {
-            friend class sftb::TextBox;
-            friend class CharPosData;
-        private:
-            using TextBox = sftb::TextBox;
+        [[nodiscard]] sf::Time getLoadTimeBudget() const {
+            return loadTimeBudget;
+        }
 
-            TextBox **box;
-            TextBox::LineLengthSet::iterator lineLengthIterator;
-            std::vector<CharInfo> characters;
-            CharPosDataHolder endLineCharPosDataHolder;
+        // maximum time spent appending the text of a file being loaded, and of the followed file, per update(). At least
+        // one chunk of each is appended
+        void setLoadTimeBudget(sf::Time budget) {
+            loadTimeBudget = budget;
+        }
 
-            auto createIterator() {
-                return getTextBox().lineLength.insert(getReference());
-            }
+        // appends the text appended to path (see FileFollower) from now on, such as a log. The document is cleared
+        // when the file is truncated or replaced. Combined with setFollow() and Document::setMaxLines() to tail a log
+        std::shared_ptr<FileFollower> followFile(const std::string &path, bool skipExisting = false);
 
-            void removeIterator() {
-                getTextBox().lineLength.erase(lineLengthIterator);
-            }
+        [[nodiscard]] const std::shared_ptr<FileFollower> &getFileFollower() const {
+            return fileFollower;
+        }
 
-            static void prepareRemove(const CharPos &transferPos, const std::vector<CharInfo>::iterator &start,
-                                      const std::vector<CharInfo>::iterator &end);
-        public:
-            explicit Line(TextBox *box) : box(box->getReference()), lineLengthIterator(createIterator()) {
-            }
+        void stopFollowingFile() {
+            fileFollower.reset();
+        }
 
-            ~Line() {
-                if (box)
-                    removeIterator();
-            }
+        // performs work spread over several frames (such as pasting large texts and loading files) and appends the
+        // text of the AppendQueue and of the followed file, should be called once per frame
+        void update();
 
-            Line(const Line &) = delete;
-            Line &operator=(const Line &) = delete;
+        [[nodiscard]] const std::shared_ptr<AppendQueue> &getAppendQueue() const {
+            return appendQueue;
+        }
 
-            Line(Line &&other) noexcept: Reference(std::move(other)), box(other.box), lineLengthIterator(std::move(other.lineLengthIterator)), characters(std::move(other.characters)),
-                                         endLineCharPosDataHolder(std::move(other.endLineCharPosDataHolder)) {
-                other.box = nullptr;
-            }
+        // text pushed to queue by other threads is appended to the document by update(), nullptr to stop
+        void setAppendQueue(std::shared_ptr<AppendQueue> queue) {
+            appendQueue = std::move(queue);
+        }
 
-            Line &operator=(Line &&other) noexcept {
-                if(&other != this) {
-                    Reference::operator=(std::move(other));
-                    if(box)
-                    removeIterator();
-                    box = other.box;
-                    other.box = nullptr;
-                    lineLengthIterator = std::move(other.lineLengthIterator);
-                    characters = std::move(other.characters);
-                    endLineCharPosDataHolder = std::move(other.endLineCharPosDataHolder);
-                }
-                return *this;
-            }
+        void handleEvent(const sf::Event &event, bool verifyArea = true);
+        void handleInput(sf::Keyboard::Key key, bool pressed, bool control, bool shift, bool alt);
+        void handleTextInput(const sf::String &string);
+        void handleScroll(bool vertical, float amount);
+        void handleInput(sf::Mouse::Button button, bool pressed, int x, int y);
+        void handleMousePositionChange(int x, int y);
 
-            inline TextBox &getTextBox() {
-                assert(box != nullptr && "line is invalid");
-                return **box;
-            }
+        // latency of the events of type passed to handleEvent(), from the call until the end of the next draw()
+        // the time until the frame is displayed (such as waiting for vertical sync) is not included
+        [[nodiscard]] const LatencyHistogram &getLatencyHistogram(InputEventType type) const {
+            return latencyHistograms[static_cast<std::size_t>(type)];
+        }
 
-            void updateLineLength() {
-                removeIterator();
-                lineLengthIterator = createIterator();
-            }
+        void resetLatencyHistograms();
 
-            [[nodiscard]] std::size_t getNumberCharacters() const {
-                assert(box != nullptr && "line is invalid");
-                return characters.size();
-            }
+        [[nodiscard]] const std::shared_ptr<EventRecorder> &getEventRecorder() const {
+            return eventRecorder;
+        }
 
-            void insert(const sf::String &string, std::size_t index = 0);
+        // every event passed to handleEvent() is recorded by recorder, nullptr to stop recording
+        void setEventRecorder(std::shared_ptr<EventRecorder> recorder) {
+            eventRecorder = std::move(recorder);
+        }
 
-            void prepareRemoveAll(const CharPos &transferPos) {
-                assert(box != nullptr && "line is invalid");
-                prepareRemove(transferPos, characters.begin(), characters.end());
-                endLineCharPosDataHolder.transfer(transferPos);
-            }
+        [[nodiscard]] Caret &getPrimaryCaret() {
+            return caret;
+        }
 
-            void remove(std::size_t start, std::size_t end = -1);
-            void move(Line &line, std::size_t start, std::size_t insertPosition);
+        [[nodiscard]] const Caret &getPrimaryCaret() const {
+            return caret;
+        }
 
-            CharInfo &getCharInfo(std::size_t position) {
-                assert(position < getNumberCharacters() && "position out of bounds");
-                return characters[position];
-            }
+        // the primary caret and any additional carets
+        [[nodiscard]] std::size_t getNumberCarets() const {
+            return additionalCarets.size() + 1;
+        }
 
-            [[nodiscard]] const CharInfo &getCharInfo(std::size_t position) const {
-                return const_cast<Line *>(this)->getCharInfo(position);
-            }
-        };
-    }
+        // index 0 is the primary caret
+        [[nodiscard]] Caret &getCaret(std::size_t index) {
+            assert(index < getNumberCarets() && "index out of bounds");
+            return index == 0 ? caret : *additionalCarets[index - 1];
+        }
+
+        [[nodiscard]] const Caret &getCaret(std::size_t index) const {
+            return const_cast<TextBox *>(this)->getCaret(index);
+        }
+
+        Caret &addCaret(const Pos &position);
+        void removeAdditionalCarets();
+        // removes additional carets which share their position with another caret
+        void mergeCarets();
+
+        // replaces the selection of every caret with text, see insertText(const std::vector<Pos> &, const sf::String &)
+        void insertAtCarets(const sf::String &text);
+        // removes the selection of every caret, and the text between each caret without a selection and the position
+        // the given number of characters from it, as a single edit. Each caret is placed at the start of its removed text
+        void removeAtCarets(int characters = 0);
+        // selects every occurrence of the primary caret's selection, with one caret per occurrence
+        void selectAllOccurrences();
+
+        [[nodiscard]] const std::optional<BlockSelection> &getBlockSelection() const {
+            return blockSelection;
+        }
+
+        void setBlockSelection(const BlockSelection &selection) {
+            assert(selection.firstLine <= selection.lastLine && selection.lastLine < getNumberLines() &&
+                   "block selection out of bounds");
+            blockSelection = selection;
+            setRedrawRequired();
+        }
+
+        void removeBlockSelection() {
+            if (!blockSelection) return;
+            blockSelection.reset();
+            setRedrawRequired();
+        }
+
+        // [start, end) of the characters of line within the block selection
+        [[nodiscard]] std::pair<std::size_t, std::size_t> getBlockSpan(std::size_t line) const;
+        // the selected part of each line of the block selection, separated by line breaks
+        [[nodiscard]] sf::String getBlockText() const;
+        // replaces the selected part of each line with text, and places a caret after the text on each line
+        void replaceBlockText(const sf::String &text);
+
+        std::shared_ptr<Highlight> highlight(const Pos &first, const Pos &second, std::shared_ptr<Highlighter> highlighter);
+
+        HighlightHandle handledHighlight(const Pos &first, const Pos &second, std::shared_ptr<Highlighter> highlighter) {
+            return HighlightHandle(highlight(first, second, std::move(highlighter)));
+        }
+
+        void removeHighlight(const std::shared_ptr<Highlight> &highlight);
+
+        [[nodiscard]] const FrameInfo &getLastFrameInfo() const {
+            return lastFrame;
+        }
+
+        // duration of the latest edit (an insertion, removal or replacement of text, which may span several lines)
+        [[nodiscard]] sf::Time getLastEditTime() const {
+            return lastEditTime;
+        }
+
+        // estimated number of bytes used by this TextBox and its text, anchors and layout, O(log(number of lines))
+        // a document shared by several TextBoxes is counted by each of them
+        [[nodiscard]] std::size_t getMemoryEstimate() const;
+
+        // counters of all TextBoxes since the last resetStats(), only collected with SFTB_ENABLE_STATS
+        [[nodiscard]] static Stats getStats();
+        static void resetStats();
+    };
 }
 
 
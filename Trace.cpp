@@ -0,0 +1,113 @@
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <thread>
+#include "Trace.hpp"
+
+namespace sftb::trace {
+    namespace {
+        // each slot is guarded by a sequence number (a seqlock): odd while the slot is being written, otherwise
+        // 2 * (index + 1) for the event with the given index. Readers skip slots which change while being read
+        struct Slot {
+            std::atomic<std::uint64_t> sequence{0};
+            std::atomic<const char *> name{nullptr};
+            std::atomic<std::uint64_t> start{0}, end{0};
+            std::atomic<std::uint32_t> thread{0};
+        };
+
+        Slot slots[CAPACITY];
+        // index of the next event
+        std::atomic<std::uint64_t> next{0};
+        std::atomic<bool> recording{false};
+
+        std::uint32_t getThreadId() {
+            thread_local std::uint32_t id = static_cast<std::uint32_t>(std::hash<std::thread::id>()(
+                    std::this_thread::get_id()));
+            return id;
+        }
+
+        void writeString(std::ostream &out, const char *string) {
+            out << '"';
+            for (; *string; string++) {
+                if (*string == '"' || *string == '\\') out << '\\';
+                out << *string;
+            }
+            out << '"';
+        }
+
+        // Chrome trace timestamps are in microseconds, written with a fixed number of decimals
+        void writeMicroseconds(std::ostream &out, std::uint64_t nanoseconds) {
+            char fill = out.fill('0');
+            out << nanoseconds / 1000 << '.' << std::setw(3) << nanoseconds % 1000;
+            out.fill(fill);
+        }
+    }
+
+    void start() {
+        recording.store(true, std::memory_order_relaxed);
+    }
+
+    void stop() {
+        recording.store(false, std::memory_order_relaxed);
+    }
+
+    bool isRecording() {
+        return recording.load(std::memory_order_relaxed);
+    }
+
+    void clear() {
+        next.store(0, std::memory_order_relaxed);
+        for (Slot &slot : slots) slot.sequence.store(0, std::memory_order_relaxed);
+    }
+
+    std::uint64_t now() {
+        // offset by one, 0 is reserved for scopes started while not recording
+        static const auto epoch = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - epoch).count() + 1;
+    }
+
+    void record(const char *name, std::uint64_t start, std::uint64_t end) {
+        std::uint64_t index = next.fetch_add(1, std::memory_order_relaxed);
+        Slot &slot = slots[index % CAPACITY];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.start.store(start, std::memory_order_relaxed);
+        slot.end.store(end, std::memory_order_relaxed);
+        slot.thread.store(getThreadId(), std::memory_order_relaxed);
+        slot.sequence.store(2 * (index + 1), std::memory_order_release);
+    }
+
+    void write(std::ostream &out) {
+        std::uint64_t end = next.load(std::memory_order_acquire);
+        std::uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (std::uint64_t index = begin; index < end; index++) {
+            const Slot &slot = slots[index % CAPACITY];
+            std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const char *name = slot.name.load(std::memory_order_relaxed);
+            std::uint64_t eventStart = slot.start.load(std::memory_order_relaxed);
+            std::uint64_t eventEnd = slot.end.load(std::memory_order_relaxed);
+            std::uint32_t thread = slot.thread.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // skip events which are being written, or were overwritten while reading
+            if (sequence != 2 * (index + 1) || slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+            if (!first) out << ',';
+            first = false;
+            // complete ("X") events
+            out << "\n{\"name\":";
+            writeString(out, name);
+            out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread << ",\"ts\":";
+            writeMicroseconds(out, eventStart);
+            out << ",\"dur\":";
+            writeMicroseconds(out, eventEnd - eventStart);
+            out << '}';
+        }
+        out << "\n]}\n";
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef SFML_TEXTBOX_TRACE_HPP
+#define SFML_TEXTBOX_TRACE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Timeline of scoped events (edits, frames, input handling), recorded into an in-memory ring buffer and written out
+ * in the Chrome trace event format, which can be opened in chrome://tracing or ui.perfetto.dev.
+ *
+ * Recording is off until trace::start() is called. The library's own events are only compiled in when
+ * SFTB_ENABLE_TRACING is defined (the cmake option of the same name); the functions below are always available, so
+ * applications can record their own events as well.
+ */
+namespace sftb::trace {
+    // number of events retained, older events are overwritten
+    constexpr std::size_t CAPACITY = 1 << 16;
+
+    void start();
+    void stop();
+    [[nodiscard]] bool isRecording();
+    // discards all recorded events
+    void clear();
+
+    // nanoseconds since an arbitrary fixed point
+    [[nodiscard]] std::uint64_t now();
+
+    // name must outlive the trace, typically a string literal
+    // lock-free, may be called from any thread
+    void record(const char *name, std::uint64_t start, std::uint64_t end);
+
+    // writes the retained events as Chrome trace JSON, may be called while events are being recorded
+    void write(std::ostream &out);
+
+    class Scope {
+    private:
+        const char *name;
+        // 0 if not recording when the scope started
+        std::uint64_t startTime;
+    public:
+        explicit Scope(const char *name) : name(name), startTime(isRecording() ? now() : 0) {}
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        ~Scope() {
+            if (startTime != 0) record(name, startTime, now());
+        }
+    };
+}
+
+#define SFTB_TRACE_CONCAT_IMPL(a, b) a##b
+#define SFTB_TRACE_CONCAT(a, b) SFTB_TRACE_CONCAT_IMPL(a, b)
+
+// records an event from this point until the end of the enclosing scope
+#ifdef SFTB_ENABLE_TRACING
+#define SFTB_TRACE_SCOPE(name) ::sftb::trace::Scope SFTB_TRACE_CONCAT(sftbTraceScope, __LINE__)(name)
+#else
+#define SFTB_TRACE_SCOPE(name) ((void) 0)
+#endif
+
+#endif //SFML_TEXTBOX_TRACE_HPP
@@ -0,0 +1,93 @@
+#ifndef SFML_TEXTBOX_UTF8_HPP
+#define SFML_TEXTBOX_UTF8_HPP
+
+#include <SFML/Config.hpp>
+#include <cstddef>
+#include <utility>
+
+namespace sftb::utf8 {
+    // number of bytes needed to encode c
+    inline std::size_t getEncodedLength(sf::Uint32 c) {
+        return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+    }
+
+    template<typename OutputIt>
+    inline OutputIt encode(sf::Uint32 c, OutputIt out) {
+        if (c < 0x80) {
+            *out++ = static_cast<char>(c);
+        } else if (c < 0x800) {
+            *out++ = static_cast<char>(0xC0u | (c >> 6u));
+            *out++ = static_cast<char>(0x80u | (c & 0x3Fu));
+        } else if (c < 0x10000) {
+            *out++ = static_cast<char>(0xE0u | (c >> 12u));
+            *out++ = static_cast<char>(0x80u | ((c >> 6u) & 0x3Fu));
+            *out++ = static_cast<char>(0x80u | (c & 0x3Fu));
+        } else {
+            *out++ = static_cast<char>(0xF0u | (c >> 18u));
+            *out++ = static_cast<char>(0x80u | ((c >> 12u) & 0x3Fu));
+            *out++ = static_cast<char>(0x80u | ((c >> 6u) & 0x3Fu));
+            *out++ = static_cast<char>(0x80u | (c & 0x3Fu));
+        }
+        return out;
+    }
+
+    template<typename OutputIt>
+    inline OutputIt encode(const sf::Uint32 *begin, const sf::Uint32 *end, OutputIt out) {
+        while (begin != end) {
+            // ascii runs are by far the most common, avoid the branches in encode()
+            while (begin != end && *begin < 0x80) {
+                *out++ = static_cast<char>(*begin++);
+            }
+            if (begin != end) out = encode(*begin++, out);
+        }
+        return out;
+    }
+
+    inline std::size_t getEncodedLength(const sf::Uint32 *begin, const sf::Uint32 *end) {
+        std::size_t length = 0;
+        for (; begin != end; begin++) {
+            length += getEncodedLength(*begin);
+        }
+        return length;
+    }
+
+    constexpr sf::Uint32 REPLACEMENT_CHARACTER = 0xFFFD;
+
+    // decodes [begin, end) to out, invalid bytes are decoded as REPLACEMENT_CHARACTER
+    // a sequence which is incomplete at the end of the input is not decoded, the first element of the result is its
+    // start (or end if there is none) so it can be decoded with the input that follows
+    template<typename OutputIt>
+    inline std::pair<const char *, OutputIt> decode(const char *begin, const char *end, OutputIt out) {
+        // smallest character for each sequence length, smaller characters are invalid (overlong)
+        constexpr sf::Uint32 MINIMUM[] = {0, 0, 0x80, 0x800, 0x10000};
+        while (begin != end) {
+            // ascii runs are by far the most common, avoid the branches below
+            while (begin != end && static_cast<unsigned char>(*begin) < 0x80) {
+                *out++ = static_cast<sf::Uint32>(*begin++);
+            }
+            if (begin == end) break;
+
+            auto lead = static_cast<unsigned char>(*begin);
+            std::ptrdiff_t length = lead >= 0xF8 ? 0 : lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 0;
+            if (length == 0) {
+                *out++ = REPLACEMENT_CHARACTER;
+                begin++;
+                continue;
+            }
+
+            sf::Uint32 c = lead & (0x7Fu >> length);
+            std::ptrdiff_t i = 1;
+            for (; i < length && begin + i != end && (static_cast<unsigned char>(begin[i]) & 0xC0u) == 0x80; i++) {
+                c = (c << 6u) | (static_cast<unsigned char>(begin[i]) & 0x3Fu);
+            }
+            if (i < length && begin + i == end) break;
+            if (i < length || c < MINIMUM[length] || (c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF)
+                c = REPLACEMENT_CHARACTER;
+            *out++ = c;
+            begin += i;
+        }
+        return {begin, out};
+    }
+}
+
+#endif //SFML_TEXTBOX_UTF8_HPP
@@ -0,0 +1,230 @@
+#include <SFML/Graphics.hpp>
+#include <TextBox.hpp>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Benchmarks the document engine without opening a window, and prints the results as JSON:
+// {"font": ..., "benchmarks": [{"name": ..., "iterations": ..., "total_ms": ..., "ns_per_iteration": ...}, ...],
+//  "skipped": [{"name": ..., "reason": ...}, ...]}
+// with SFTB_ENABLE_STATS, each benchmark also reports the number of heap allocations made by its body
+//
+// usage: SFML_TextBox_bench [font file] [event recording [initial text file]]
+// with an event recording (see sftb::EventRecorder), the recorded events are also replayed as fast as possible into a
+// TextBox of WIDTH x HEIGHT, initially containing the given UTF-8 text, drawing a frame whenever one is required
+// SFML still creates an OpenGL context for glyph textures and the draw benchmark, but no window is shown
+
+namespace {
+    constexpr unsigned WIDTH = 1280;
+    constexpr unsigned HEIGHT = 720;
+    constexpr std::size_t LINE_LENGTH = 80;
+
+    struct Result {
+        std::string name;
+        std::size_t iterations;
+        double totalMilliseconds;
+        std::size_t allocations;
+    };
+
+    std::vector<Result> results;
+    // benchmarks which could not run, with the reason
+    std::vector<std::pair<std::string, std::string>> skipped;
+
+    // runs setup() (untimed) followed by body() (timed), body performs `iterations` operations
+    template<typename Setup, typename Body>
+    void benchmark(const std::string &name, std::size_t iterations, Setup setup, Body body) {
+        auto state = setup();
+        sftb::TextBox::resetStats();
+        auto start = std::chrono::steady_clock::now();
+        body(state);
+        auto end = std::chrono::steady_clock::now();
+        results.push_back({name, iterations, std::chrono::duration<double, std::milli>(end - start).count(),
+                           sftb::TextBox::getStats().allocations});
+    }
+
+    void skip(const std::string &name, const std::string &reason) {
+        std::cerr << "Skipping " << name << ": " << reason << std::endl;
+        skipped.emplace_back(name, reason);
+    }
+
+    // the target of the draw benchmarks, nullptr if it cannot be created (such as without an OpenGL context)
+    std::unique_ptr<sf::RenderTexture> makeTexture() {
+        auto texture = std::make_unique<sf::RenderTexture>();
+        if (!texture->create(WIDTH, HEIGHT)) return nullptr;
+        return texture;
+    }
+
+    sf::String makeLine(std::mt19937 &random, std::size_t length) {
+        static const std::string characters = "abcdefghijklmnopqrstuvwxyz      ,.;(){}0123456789";
+        std::basic_string<sf::Uint32> line(length, ' ');
+        for (auto &c : line) c = static_cast<unsigned char>(characters[random() % characters.size()]);
+        return line;
+    }
+
+    sf::String makeText(std::size_t lines, std::size_t length = LINE_LENGTH) {
+        std::mt19937 random(lines);
+        sf::String text;
+        for (std::size_t i = 0; i < lines; i++) {
+            if (i > 0) text += '\n';
+            text += makeLine(random, length);
+        }
+        return text;
+    }
+
+    std::unique_ptr<sftb::TextBox> makeDocument(sf::Font &font, std::size_t lines, std::size_t length = LINE_LENGTH) {
+        auto box = std::make_unique<sftb::TextBox>(font, sf::Vector2f(WIDTH, HEIGHT));
+        box->insertText({0, 0}, makeText(lines, length));
+        return box;
+    }
+
+    std::string quote(const std::string &string) {
+        std::string quoted = "\"";
+        for (char c : string) {
+            if (c == '"' || c == '\\') quoted += '\\';
+            quoted += c;
+        }
+        return quoted + '"';
+    }
+
+    void printResults(const std::string &fontFile) {
+        std::cout << "{\n  \"font\": " << quote(fontFile) << ",\n  \"benchmarks\": [\n";
+        for (std::size_t i = 0; i < results.size(); i++) {
+            const Result &result = results[i];
+            std::cout << "    {\"name\": " << quote(result.name) << ", \"iterations\": " << result.iterations
+                      << ", \"total_ms\": " << result.totalMilliseconds
+                      << ", \"ns_per_iteration\": " << result.totalMilliseconds * 1e6 / static_cast<double>(result.iterations);
+#ifdef SFTB_ENABLE_STATS
+            std::cout << ", \"allocations\": " << result.allocations;
+#endif
+            std::cout << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        std::cout << "  ],\n  \"skipped\": [\n";
+        for (std::size_t i = 0; i < skipped.size(); i++) {
+            std::cout << "    {\"name\": " << quote(skipped[i].first) << ", \"reason\": " << quote(skipped[i].second) << "}"
+                      << (i + 1 < skipped.size() ? "," : "") << "\n";
+        }
+        std::cout << "  ]\n}" << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string fontFile = argc > 1 ? argv[1] : SFTB_BENCH_FONT;
+    sf::Font font;
+    if (!font.loadFromFile(fontFile)) {
+        std::cerr << "Could not load font " << fontFile << std::endl;
+        return 1;
+    }
+
+    // typing at the end of a document, one character per insertText
+    benchmark("type_characters", 100000, [&] { return makeDocument(font, 10000); }, [](auto &box) {
+        sftb::Pos pos{box->getNumberLines() - 1, box->getLineLength(box->getNumberLines() - 1)};
+        for (std::size_t i = 0; i < 100000; i++) {
+            pos = box->insertText(pos, i % LINE_LENGTH == LINE_LENGTH - 1 ? "\n" : "a");
+        }
+    });
+
+    // typing in the middle of a long line
+    benchmark("type_characters_long_line", 10000, [&] { return makeDocument(font, 1, 100000); }, [](auto &box) {
+        sftb::Pos pos{0, 50000};
+        for (std::size_t i = 0; i < 10000; i++) pos = box->insertText(pos, "a");
+    });
+
+    // pasting 100k lines into the middle of a document
+    benchmark("paste_100k_lines", 1, [&] {
+        return std::make_pair(makeDocument(font, 100000), makeText(100000));
+    }, [](auto &state) {
+        state.first->insertText({50000, 40}, state.second);
+    });
+
+    // inserting lines at the top of a document, shifting every following line
+    benchmark("insert_line_top", 1000, [&] { return makeDocument(font, 100000); }, [](auto &box) {
+        for (std::size_t i = 0; i < 1000; i++) box->insertLine(0, "inserted line");
+    });
+
+    // removing ranges spanning several lines
+    benchmark("remove_range", 1000, [&] { return makeDocument(font, 100000); }, [](auto &box) {
+        for (std::size_t i = 0; i < 1000; i++) box->removeText({i * 10, 20}, {i * 10 + 50, 40});
+    });
+
+    // creating anchors, editing around them and resolving them again
+    benchmark("char_pos_anchors", 100000, [&] { return makeDocument(font, 100000); }, [](auto &box) {
+        std::vector<sftb::CharPos> anchors;
+        anchors.reserve(100000);
+        for (std::size_t i = 0; i < 100000; i++) anchors.push_back(box->getCharPos({i, i % LINE_LENGTH}));
+        for (std::size_t i = 0; i < 1000; i++) box->insertText({i * 100, 0}, "edit\n");
+        std::size_t sum = 0;
+        for (const sftb::CharPos &anchor : anchors) sum += box->getPositionOfChar(anchor).position;
+        if (sum == 0) std::cerr << "unexpected anchor positions" << std::endl;
+    });
+
+    // extracting the whole document
+    benchmark("get_text_from", 10, [&] { return makeDocument(font, 100000); }, [](auto &box) {
+        std::size_t size = 0;
+        for (int i = 0; i < 10; i++) size += box->getTextFrom(box->getStartPos(), box->getEndPos()).getSize();
+        if (size == 0) std::cerr << "unexpected text size" << std::endl;
+    });
+
+    // moving by a few thousand characters at a time
+    benchmark("get_relative_characters", 100000, [&] { return makeDocument(font, 100000); }, [](auto &box) {
+        std::mt19937 random(1);
+        sftb::Pos pos{50000, 0};
+        for (std::size_t i = 0; i < 100000; i++) {
+            pos = box->getRelativeCharacters(pos, static_cast<int>(random() % 8001) - 4000);
+        }
+    });
+
+    // drawing into an invalid target would time nothing, the draw benchmarks are skipped instead
+    const std::string noTexture = "could not create a " + std::to_string(WIDTH) + "x" + std::to_string(HEIGHT) +
+                                  " render texture (no OpenGL context?)";
+    bool canDraw = makeTexture() != nullptr;
+
+    // drawing frames while scrolling through a document, into a texture rather than a window
+    if (canDraw) {
+        benchmark("draw_frames", 200, [&] {
+            return std::make_pair(makeDocument(font, 100000), makeTexture());
+        }, [](auto &state) {
+            for (std::size_t i = 0; i < 200; i++) {
+                state.first->getScrollBarManager().getVerticalScrollBar().moveScroll(100);
+                state.second->clear();
+                state.second->draw(*state.first);
+            }
+            state.second->display();
+        });
+    } else skip("draw_frames", noTexture);
+
+    if (argc > 2) {
+        std::string recordingFile = argv[2];
+        std::string initialText;
+        if (argc > 3) {
+            std::ifstream textFile(argv[3], std::ios::binary);
+            initialText.assign(std::istreambuf_iterator<char>(textFile), std::istreambuf_iterator<char>());
+        }
+
+        std::ifstream recording(recordingFile, std::ios::binary);
+        sftb::EventReplayer replayer(recording);
+        if (!replayer.isValid()) {
+            std::cerr << "Could not read event recording " << recordingFile << std::endl;
+            return 1;
+        }
+
+        if (canDraw) {
+            std::size_t events = 0;
+            benchmark("replay", 1, [&] {
+                auto box = std::make_unique<sftb::TextBox>(font, sf::Vector2f(WIDTH, HEIGHT));
+                box->insertText({0, 0}, sf::String::fromUtf8(initialText.begin(), initialText.end()));
+                return std::make_pair(std::move(box), makeTexture());
+            }, [&](auto &state) {
+                events = replayer.replay(*state.first, state.second.get());
+            });
+            // per event rather than per replay
+            results.back().iterations = std::max<std::size_t>(events, 1);
+        } else skip("replay", noTexture);
+    }
+
+    printResults(fontFile);
+}
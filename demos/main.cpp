@@ -1,12 +1,14 @@
 #include <SFML/Graphics.hpp>
 #include <TextBox.hpp>
+#include <PerformanceOverlay.hpp>
+#include <fstream>
 #include <iostream>
 
 const char *fontFile = "font.ttf";
 constexpr unsigned WIDTH = 800;
 constexpr unsigned HEIGHT = 600;
 
-int main() {
+int main(int argc, char **argv) {
     // This demo is a modified version of the code from sfml's "Drawing 2D stuff" tutorial
     // https://www.sfml-dev.org/tutorials/2.5/
 
@@ -14,7 +16,7 @@ int main() {
     sf::Font font;
     if (!font.loadFromFile(fontFile)) {
         std::cerr << "A font must be provided in order for this demo to work!" << std::endl;
-        std::cerr << "Make sure a monospaced font file named " + std::string(fontFile) + " exists next to this executable."
+        std::cerr << "Make sure a font file named " + std::string(fontFile) + " exists next to this executable."
                   << std::endl;
         std::cerr << "Press Enter to exit." << std::endl;
         std::cin.get();
@@ -28,6 +30,17 @@ int main() {
     box.setBackgroundColor(sf::Color(backgroundBrightness, backgroundBrightness, backgroundBrightness));
     box.insertText({0, 0}, "Hello, World!");
 
+    // optionally record the session to the file given as the first argument, see sftb::EventReplayer
+    std::ofstream recording;
+    if (argc > 1) {
+        recording.open(argv[1], std::ios::binary);
+        box.setEventRecorder(std::make_shared<sftb::EventRecorder>(recording));
+    }
+
+    // performance overlay, toggled with F3
+    sftb::PerformanceOverlay overlay(box);
+    bool showOverlay = false;
+
     // create window
     sf::RenderWindow window(sf::VideoMode(WIDTH, HEIGHT), "SFML_TextBox demo");
 
@@ -40,6 +53,10 @@ int main() {
             // handle event
             if (event.type == sf::Event::Closed)
                 window.close();
+            else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F3) {
+                showOverlay = !showOverlay;
+                box.setRedrawRequired();
+            }
             else if (event.type == sf::Event::Resized) {
                 // update draw area to reflect updated size
                 window.setView(sf::View(sf::FloatRect(0.0f, 0.0f, event.size.width, event.size.height)));
@@ -49,11 +66,15 @@ int main() {
 
         // event queue is now empty
 
+        // continue work spread over several frames, such as large pastes
+        box.update();
+
         // if content has changed, clear the screen and redraw
         if (box.isRedrawRequired()) {
             window.clear(sf::Color::Magenta);
             // draw text box
             window.draw(box);
+            if (showOverlay) window.draw(overlay);
             // end
             window.display();
         }